@@ -0,0 +1,457 @@
+/*
+ * Batch evaluation of statistics over many calculators.
+ *
+ * evaluate_batch() fills a row-major result matrix: one row per calculator
+ * and one column per statistic selected in the mask, in BATCH_* bit order.
+ * Each calculator is visited once. A single fused pass over its data yields
+ * the count, exact sum, sum of squares, min and max, and every requested
+ * moment is derived from those. The median comes from the cached sorted data
+ * when there is one. Calculators of up to SMALL_NETWORK_MAX values take it
+ * from median networks run across vector lanes, a block at a time. Others
+ * use the histogram if cached, and otherwise quickselect on a per-thread
+ * scratch copy, which costs O(n) where a sort would cost O(n log n).
+ * Results are doubles from exact integer sums. The sum, min, max, mean,
+ * median and range are also cached back, in the engine's float rounding.
+ *
+ * Calculators are split into one contiguous range per thread. A thread
+ * takes small blocks from the front of its own range, and when that runs
+ * out it steals half of what is left at the back of the busiest range.
+ * That keeps threads busy when calculator sizes are very uneven.
+ *
+ * Empty calculators, and the sample standard deviation of fewer than two
+ * values, yield NaN.
+ *
+ * Build:
+ *   gcc -O2 -pthread MultiParadigmBatch.c -o batch -lm
+ *   ./batch [calculators] [values_per_calculator] [threads]
+ */
+
+#ifndef MULTIPARADIGM_BATCH_INCLUDED
+#define MULTIPARADIGM_BATCH_INCLUDED
+
+#define STATS_NO_MAIN
+#include "MultiParadigmC.c"
+
+#include <pthread.h>
+
+#define BATCH_COUNT              0x001
+#define BATCH_SUM                0x002
+#define BATCH_MEAN               0x004
+#define BATCH_MEDIAN             0x008
+#define BATCH_STD_DEV_SAMPLE     0x010
+#define BATCH_STD_DEV_POPULATION 0x020
+#define BATCH_MIN                0x040
+#define BATCH_MAX                0x080
+#define BATCH_RANGE              0x100
+#define BATCH_ALL                0x1FF
+
+#define BATCH_BLOCK 16   // Calculators taken from the own range at a time
+
+typedef struct {
+    pthread_mutex_t lock;
+    int next;            // Owner takes from here
+    int end;             // Thieves take from here
+} BatchRange;
+
+typedef struct {
+    StatisticsCalculator* const* calcs;
+    unsigned mask;
+    int columns;
+    double* results;
+    BatchRange* ranges;
+    int range_count;
+} BatchJob;
+
+typedef struct {
+    BatchJob* job;
+    int index;
+    int* scratch;        // Selection buffer, grown on demand
+    int scratch_capacity;
+} BatchWorker;
+
+// Number of result columns for a statistic mask
+int batch_columns(unsigned mask) {
+    return __builtin_popcount(mask & BATCH_ALL);
+}
+
+// Smallest value at index k after partitioning values[0..n) around it
+static int select_kth(int values[], int n, int k) {
+    int low = 0, high = n - 1;
+    while (high > low) {
+        int middle = low + (high - low) / 2;
+        // Median of three as the pivot
+        int a = values[low], b = values[middle], c = values[high];
+        int pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+        int i = low, j = high;
+        while (i <= j) {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j) {
+                int swap = values[i];
+                values[i++] = values[j];
+                values[j--] = swap;
+            }
+        }
+        if (k <= j) {
+            high = j;
+        } else if (k >= i) {
+            low = i;
+        } else {
+            return values[k];
+        }
+    }
+    return values[k];
+}
+
+// Median of the unsorted data, selected in a copy held by the worker
+static double select_median(StatisticsCalculator* calc, BatchWorker* worker) {
+    int n = calc->count;
+    if (n > worker->scratch_capacity) {
+        int* grown = (int*)realloc(worker->scratch, (size_t)n * sizeof(int));
+        if (grown == NULL) {
+            sort_data(calc);  // Fall back to the engine's cached sort
+            int half = n / 2;
+            return n % 2 ? calc->sorted_data[half]
+                         : ((double)calc->sorted_data[half - 1] + calc->sorted_data[half]) / 2.0;
+        }
+        worker->scratch = grown;
+        worker->scratch_capacity = n;
+    }
+    int* values = worker->scratch;
+    memcpy(values, calc->data, (size_t)n * sizeof(int));
+    int half = n / 2;
+    int upper = select_kth(values, n, half);
+    if (n % 2) {
+        return upper;
+    }
+    // After selection everything below `half` is <= upper; the lower middle is their max
+    int lower = values[0];
+    for (int i = 1; i < half; i++) {
+        lower = values[i] > lower ? values[i] : lower;
+    }
+    return ((double)lower + upper) / 2.0;
+}
+
+// Evaluate the masked statistics of one calculator into `row`; `small_median`
+// is its median from calculate_small_medians(), or NaN
+static void evaluate_calculator(StatisticsCalculator* calc, unsigned mask, double row[], BatchWorker* worker,
+                                double small_median) {
+    int n = calc->count;
+    int need_moments = (mask & BATCH_SUM) || (mask & BATCH_MEAN && !(calc->cache_flags & CACHE_SUM)) ||
+                       (mask & (BATCH_STD_DEV_SAMPLE | BATCH_STD_DEV_POPULATION));
+    int known_extremes = calc->cache_flags & (CACHE_SORTED | CACHE_MIN) && calc->cache_flags & (CACHE_SORTED | CACHE_MAX);
+    int need_extremes = (mask & (BATCH_MIN | BATCH_MAX | BATCH_RANGE)) && !known_extremes;
+    long long sum = 0;
+    __int128 sum_squares = 0;
+    int min = 0, max = 0;
+
+    if (n > 0 && (need_moments || need_extremes)) {
+        const int* data = calc->data;
+        if (calc->cache_flags & CACHE_SUM && !(mask & (BATCH_STD_DEV_SAMPLE | BATCH_STD_DEV_POPULATION)) &&
+            !need_extremes) {
+            sum = calc->cache_sum;
+        } else {
+            min = max = data[0];
+            for (int i = 0; i < n; i++) {
+                int x = data[i];
+                sum += x;
+                sum_squares += (long long)x * x;
+                min = x < min ? x : min;
+                max = x > max ? x : max;
+            }
+            calc->cache_sum = sum;
+            calc->cache_min = min;
+            calc->cache_max = max;
+            calc->cache_flags |= CACHE_SUM | CACHE_MIN | CACHE_MAX;
+        }
+    }
+    if (n > 0 && !need_extremes && (mask & (BATCH_MIN | BATCH_MAX | BATCH_RANGE))) {
+        require_statistics(calc, CACHE_MIN | CACHE_MAX);  // Read off the sorted data or cached
+        min = calc->cache_min;
+        max = calc->cache_max;
+    }
+
+    int column = 0;
+    for (unsigned bit = BATCH_COUNT; bit <= BATCH_RANGE; bit <<= 1) {
+        if (!(mask & bit)) {
+            continue;
+        }
+        double value = NAN;
+        if (bit == BATCH_COUNT) {
+            value = n;
+        } else if (n == 0) {
+            value = bit == BATCH_SUM ? 0.0 : NAN;
+        } else if (bit == BATCH_SUM) {
+            value = (double)sum;
+        } else if (bit == BATCH_MEAN) {
+            value = (double)calc->cache_sum / n;  // need_moments made sure the sum is cached
+            if (!(calc->cache_flags & CACHE_MEAN)) {
+                calc->cache_mean = (float)value;
+                calc->cache_flags |= CACHE_MEAN;
+            }
+        } else if (bit == BATCH_MEDIAN) {
+            if (calc->cache_flags & CACHE_SORTED) {
+                value = calculate_median_double(calc);  // Read off the sorted data
+            } else if (!isnan(small_median)) {
+                value = small_median;
+            } else if (calc->cache_flags & CACHE_HISTOGRAM) {
+                value = calculate_median_double(calc);  // Walk the histogram; no selection needed
+            } else {
+                value = select_median(calc, worker);
+            }
+            if (!(calc->cache_flags & CACHE_MEDIAN)) {
+                calc->cache_median = (float)value;  // Same rounding as calculate_median
+                calc->cache_flags |= CACHE_MEDIAN;
+            }
+        } else if (bit == BATCH_STD_DEV_SAMPLE || bit == BATCH_STD_DEV_POPULATION) {
+            int divisor = bit == BATCH_STD_DEV_SAMPLE ? n - 1 : n;
+            if (divisor > 0) {
+                // n * sum(x^2) - sum(x)^2 is exact in 128 bits for any int data
+                __int128 scaled = (__int128)n * sum_squares - (__int128)sum * sum;
+                value = sqrt((double)((long double)scaled / ((long double)n * divisor)));
+            }
+        } else if (bit == BATCH_MIN) {
+            value = min;
+        } else if (bit == BATCH_MAX) {
+            value = max;
+        } else if (bit == BATCH_RANGE) {
+            if (!(calc->cache_flags & CACHE_RANGE)) {
+                calc->cache_range = max - min;
+                calc->cache_flags |= CACHE_RANGE;
+            }
+            value = calc->cache_range;
+        }
+        row[column++] = value;
+    }
+}
+
+// Take up to `block` calculators from the front of a range
+static int take_own(BatchRange* range, int block, int* first) {
+    pthread_mutex_lock(&range->lock);
+    int available = range->end - range->next;
+    int taken = available < block ? available : block;
+    *first = range->next;
+    range->next += taken;
+    pthread_mutex_unlock(&range->lock);
+    return taken;
+}
+
+// Move half of the fullest other range into `own`; 0 when nothing is left
+static int steal(BatchJob* job, int thief) {
+    int victim = -1, most = 0;
+    for (int i = 0; i < job->range_count; i++) {
+        int remaining = job->ranges[i].end - job->ranges[i].next;  // A racy read is fine for picking
+        if (i != thief && remaining > most) {
+            most = remaining;
+            victim = i;
+        }
+    }
+    if (victim < 0) {
+        return 0;
+    }
+    BatchRange* range = &job->ranges[victim];
+    pthread_mutex_lock(&range->lock);
+    int remaining = range->end - range->next;
+    int taken = remaining > 1 ? remaining / 2 : remaining;
+    range->end -= taken;
+    int first = range->end;
+    pthread_mutex_unlock(&range->lock);
+    if (taken == 0) {
+        return 1;  // Lost a race; look again
+    }
+    BatchRange* own = &job->ranges[thief];
+    pthread_mutex_lock(&own->lock);
+    own->next = first;
+    own->end = first + taken;
+    pthread_mutex_unlock(&own->lock);
+    return 1;
+}
+
+// Evaluate calculators [first, first + taken), taken <= BATCH_BLOCK
+static void evaluate_block(StatisticsCalculator* const calcs[], int first, int taken, unsigned mask, int columns,
+                           double results[], BatchWorker* worker) {
+    double small_medians[BATCH_BLOCK];
+    if (mask & BATCH_MEDIAN) {
+        calculate_small_medians(calcs + first, taken, small_medians);
+    }
+    for (int i = 0; i < taken; i++) {
+        evaluate_calculator(calcs[first + i], mask, &results[(size_t)(first + i) * columns], worker,
+                            mask & BATCH_MEDIAN ? small_medians[i] : NAN);
+    }
+}
+
+static void* batch_worker(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    BatchJob* job = worker->job;
+    for (;;) {
+        int first;
+        int taken = take_own(&job->ranges[worker->index], BATCH_BLOCK, &first);
+        if (taken == 0) {
+            if (!steal(job, worker->index)) {
+                return NULL;
+            }
+            continue;
+        }
+        evaluate_block(job->calcs, first, taken, job->mask, job->columns, job->results, worker);
+    }
+}
+
+// Evaluate the statistics in `mask` for every calculator into `results`
+// (count rows of batch_columns(mask) doubles) using `threads` threads, or
+// one per CPU when threads is 0. Each calculator must appear only once and
+// must not be modified concurrently. Returns 0, or -1 if setup failed.
+int evaluate_batch(StatisticsCalculator* const calcs[], int count, unsigned mask, double results[], int threads) {
+    int columns = batch_columns(mask);
+    if (count <= 0 || columns == 0) {
+        return 0;
+    }
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > (count + BATCH_BLOCK - 1) / BATCH_BLOCK) {
+        threads = (count + BATCH_BLOCK - 1) / BATCH_BLOCK;
+    }
+    if (threads <= 1) {
+        BatchWorker worker = {NULL, 0, NULL, 0};
+        for (int first = 0; first < count; first += BATCH_BLOCK) {
+            int taken = count - first < BATCH_BLOCK ? count - first : BATCH_BLOCK;
+            evaluate_block(calcs, first, taken, mask & BATCH_ALL, columns, results, &worker);
+        }
+        free(worker.scratch);
+        return 0;
+    }
+
+    BatchRange* ranges = (BatchRange*)malloc((size_t)threads * sizeof(BatchRange));
+    BatchWorker* workers = (BatchWorker*)malloc((size_t)threads * sizeof(BatchWorker));
+    pthread_t* handles = (pthread_t*)malloc((size_t)threads * sizeof(pthread_t));
+    if (ranges == NULL || workers == NULL || handles == NULL) {
+        printf("Memory allocation failed\n");
+        free(ranges);
+        free(workers);
+        free(handles);
+        return -1;
+    }
+    BatchJob job = {calcs, mask & BATCH_ALL, columns, results, ranges, threads};
+    for (int t = 0; t < threads; t++) {
+        pthread_mutex_init(&ranges[t].lock, NULL);
+        ranges[t].next = (int)((long long)count * t / threads);
+        ranges[t].end = (int)((long long)count * (t + 1) / threads);
+        workers[t].job = &job;
+        workers[t].index = t;
+        workers[t].scratch = NULL;
+        workers[t].scratch_capacity = 0;
+    }
+    int started = 1;
+    for (; started < threads; started++) {
+        if (pthread_create(&handles[started], NULL, batch_worker, &workers[started]) != 0) {
+            break;  // Ranges of threads that never started get stolen
+        }
+    }
+    batch_worker(&workers[0]);
+    for (int t = 1; t < started; t++) {
+        pthread_join(handles[t], NULL);
+    }
+    for (int t = 0; t < threads; t++) {
+        pthread_mutex_destroy(&ranges[t].lock);
+        free(workers[t].scratch);
+    }
+    free(ranges);
+    free(workers);
+    free(handles);
+    return 0;
+}
+
+#ifndef BATCH_NO_MAIN
+static double batch_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Fill calculators with uneven sizes (1x to 8x the average) so stealing matters
+static StatisticsCalculator** make_calculators(int count, int values, unsigned int seed) {
+    StatisticsCalculator** calcs = (StatisticsCalculator**)malloc((size_t)count * sizeof(StatisticsCalculator*));
+    int* buffer = (int*)malloc((size_t)values * 8 * sizeof(int));
+    if (calcs == NULL || buffer == NULL) {
+        printf("Memory allocation failed\n");
+        free(calcs);
+        free(buffer);
+        return NULL;
+    }
+    for (int i = 0; i < count; i++) {
+        int n = values / 4 + (int)(rand_r(&seed) % (unsigned)(values * 2));
+        for (int k = 0; k < n; k++) {
+            buffer[k] = (int)(rand_r(&seed) % 100000) - 50000;
+        }
+        calcs[i] = create_calculator();
+        add_values(calcs[i], buffer, n);
+    }
+    free(buffer);
+    return calcs;
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    int values = argc > 2 ? atoi(argv[2]) : 100;
+    int threads = argc > 3 ? atoi(argv[3]) : 0;
+    if (count <= 0 || values <= 0) {
+        printf("Usage: %s [calculators] [values_per_calculator] [threads]\n", argv[0]);
+        return 1;
+    }
+    unsigned mask = BATCH_MEAN | BATCH_MEDIAN | BATCH_STD_DEV_SAMPLE;
+    int columns = batch_columns(mask);
+    StatisticsCalculator** separate = make_calculators(count, values, 42);
+    StatisticsCalculator** batched = make_calculators(count, values, 42);
+    double* results = (double*)malloc((size_t)count * columns * sizeof(double));
+    if (separate == NULL || batched == NULL || results == NULL) {
+        return 1;
+    }
+
+    double start = batch_seconds();
+    double checksum = 0.0;
+    for (int i = 0; i < count; i++) {
+        checksum += calculate_mean(separate[i]);
+        checksum += calculate_median(separate[i]);
+        if (separate[i]->count > 1) {
+            checksum += calculate_std_dev(separate[i], 0);
+        }
+    }
+    double separate_seconds = batch_seconds() - start;
+
+    start = batch_seconds();
+    evaluate_batch(batched, count, mask, results, threads);
+    double batch_elapsed = batch_seconds() - start;
+
+    double batch_checksum = 0.0;
+    double worst = 0.0;
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < columns; c++) {
+            double value = results[(size_t)i * columns + c];
+            if (!isnan(value)) {
+                batch_checksum += value;
+            }
+        }
+        if (separate[i]->count > 1) {
+            double expected = calculate_std_dev(separate[i], 0);
+            double error = fabs(results[(size_t)i * columns + 2] - expected) / (fabs(expected) + 1e-9);
+            worst = error > worst ? error : worst;
+        }
+    }
+    printf("Calculators: %d, average values: ~%d, statistics: mean, median, sample std dev\n", count, values);
+    printf("Separate calls: %.3f s\n", separate_seconds);
+    printf("evaluate_batch: %.3f s (%.1fx)\n", batch_elapsed, separate_seconds / batch_elapsed);
+    printf("Checksums: %.6e vs %.6e, worst std dev relative difference %.2e\n",
+           checksum, batch_checksum, worst);
+    for (int i = 0; i < count; i++) {
+        free_calculator(separate[i]);
+        free_calculator(batched[i]);
+    }
+    free(separate);
+    free(batched);
+    free(results);
+    return 0;
+}
+#endif /* BATCH_NO_MAIN */
+
+#endif /* MULTIPARADIGM_BATCH_INCLUDED */
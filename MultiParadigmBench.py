@@ -0,0 +1,171 @@
+"""Cross-implementation benchmark and equivalence harness.
+
+Generates datasets, runs every available StatisticsCalculator implementation
+on them through its ``--bench`` mode, checks that the results agree with the
+pure-Python reference and reports time, throughput and peak memory per
+operation and size.
+
+Implementations:
+    python    MultiParadigmPython.py (pure Python, the reference)
+    python-c  MultiParadigmPython.py through the statscalc C binding
+    c         MultiParadigmC.c, compiled on the fly when --c-binary is not given
+    ocaml     MultiParadigmOCaml.ml, when --ocaml-binary is given
+
+Usage:
+    python3 MultiParadigmBench.py [--sizes 1000,10000,100000]
+        [--distributions uniform,narrow,sorted,duplicates] [--seed N]
+        [--c-binary PATH] [--ocaml-binary PATH] [--timeout SECONDS]
+
+Memory is the process high-water mark after each operation (peak RSS for
+C and Python, peak major heap for OCaml), so it includes the loaded dataset.
+"""
+
+import argparse
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+from typing import Dict, List, Optional, Tuple
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+OPERATIONS = ["add_values", "mean", "median", "mode",
+              "std_dev_sample", "std_dev_population", "range"]
+FLOAT_OPERATIONS = {"mean", "median", "std_dev_sample", "std_dev_population"}
+
+# C keeps its cached results in single precision
+RELATIVE_TOLERANCE = 1e-5
+ABSOLUTE_TOLERANCE = 1e-6
+
+
+def generate_dataset(distribution: str, size: int, rng: random.Random) -> List[int]:
+    """Generate `size` integers following one of the named distributions."""
+    if distribution == "uniform":
+        return [rng.randint(-1_000_000, 1_000_000) for _ in range(size)]
+    if distribution == "narrow":
+        return [rng.randint(0, 100) for _ in range(size)]
+    if distribution == "sorted":
+        return sorted(rng.randint(0, 10 * size) for _ in range(size))
+    if distribution == "duplicates":
+        pool = [rng.randint(-1000, 1000) for _ in range(max(1, size // 100))]
+        return [rng.choice(pool) for _ in range(size)]
+    raise ValueError(f"Unknown distribution: {distribution}")
+
+
+def build_c_binary(directory: str) -> Optional[str]:
+    """Compile MultiParadigmC.c into `directory`, or return None without a compiler."""
+    compiler = shutil.which("cc") or shutil.which("gcc")
+    if compiler is None:
+        return None
+    binary = os.path.join(directory, "multiparadigm_c")
+    source = os.path.join(HERE, "MultiParadigmC.c")
+    subprocess.run([compiler, "-O2", source, "-o", binary, "-lm"], check=True)
+    return binary
+
+
+def implementation_commands(args: argparse.Namespace, workdir: str) -> Dict[str, List[str]]:
+    """Map each available implementation to the command that runs its bench mode."""
+    python_script = os.path.join(HERE, "MultiParadigmPython.py")
+    commands = {"python": [sys.executable, python_script, "--bench", "{path}", "python"]}
+    try:
+        import statscalc  # noqa: F401
+        commands["python-c"] = [sys.executable, python_script, "--bench", "{path}", "c"]
+    except ImportError:
+        print("note: statscalc extension not built, skipping python-c", file=sys.stderr)
+    c_binary = args.c_binary or build_c_binary(workdir)
+    if c_binary:
+        commands["c"] = [c_binary, "--bench", "{path}"]
+    if args.ocaml_binary:
+        commands["ocaml"] = [args.ocaml_binary, "--bench", "{path}"]
+    return commands
+
+
+def run_implementation(command: List[str], path: str,
+                       timeout: float) -> Tuple[Dict[str, Tuple[float, int, str]], str]:
+    """Run one bench command and parse its `op size seconds peak_kb result` lines."""
+    argv = [part.replace("{path}", path) for part in command]
+    try:
+        completed = subprocess.run(argv, capture_output=True, text=True, timeout=timeout)
+    except subprocess.TimeoutExpired:
+        return {}, "timeout"
+    if completed.returncode != 0:
+        return {}, f"exit {completed.returncode}"
+    results = {}
+    for line in completed.stdout.splitlines():
+        fields = line.split("\t")
+        if len(fields) == 5 and fields[0] in OPERATIONS:
+            results[fields[0]] = (float(fields[2]), int(fields[3]), fields[4])
+    return results, "ok"
+
+
+def results_agree(operation: str, expected: str, actual: str) -> bool:
+    """Compare two printed results, with tolerance for floats and order-free modes."""
+    if operation in FLOAT_OPERATIONS:
+        a, b = float(expected), float(actual)
+        return abs(a - b) <= max(ABSOLUTE_TOLERANCE, RELATIVE_TOLERANCE * abs(a))
+    if operation == "mode":
+        return sorted(int(v) for v in expected.split(",")) == sorted(int(v) for v in actual.split(","))
+    return int(expected) == int(actual)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--sizes", default="1000,10000,100000")
+    parser.add_argument("--distributions", default="uniform,narrow,sorted,duplicates")
+    parser.add_argument("--seed", type=int, default=42)
+    parser.add_argument("--c-binary")
+    parser.add_argument("--ocaml-binary")
+    parser.add_argument("--timeout", type=float, default=120.0)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    sizes = [int(s) for s in args.sizes.split(",")]
+    distributions = args.distributions.split(",")
+    mismatches = 0
+
+    with tempfile.TemporaryDirectory() as workdir:
+        commands = implementation_commands(args, workdir)
+        header = f"{'impl':<9} {'dist':<11} {'size':>8} {'operation':<19} " \
+                 f"{'ms':>10} {'Mvalues/s':>10} {'peak KB':>9}  agree"
+        print(header)
+        print("-" * len(header))
+        for distribution in distributions:
+            for size in sizes:
+                path = os.path.join(workdir, f"{distribution}_{size}.txt")
+                with open(path, "w") as f:
+                    f.write("\n".join(map(str, generate_dataset(distribution, size, rng))))
+
+                reference, status = run_implementation(commands["python"], path, args.timeout)
+                if status != "ok":
+                    print(f"python reference failed on {distribution}/{size}: {status}")
+                    mismatches += 1
+                    continue
+                for name, command in commands.items():
+                    results, status = run_implementation(command, path, args.timeout)
+                    if status != "ok":
+                        print(f"{name:<9} {distribution:<11} {size:>8} {status}")
+                        mismatches += 1
+                        continue
+                    for operation in OPERATIONS:
+                        if operation not in results:
+                            print(f"{name:<9} {distribution:<11} {size:>8} {operation:<19} missing")
+                            mismatches += 1
+                            continue
+                        seconds, peak_kb, value = results[operation]
+                        agree = results_agree(operation, reference[operation][2], value)
+                        mismatches += not agree
+                        throughput = size / seconds / 1e6 if seconds > 0 else float("inf")
+                        print(f"{name:<9} {distribution:<11} {size:>8} {operation:<19} "
+                              f"{seconds * 1e3:>10.3f} {throughput:>10.2f} {peak_kb:>9}  "
+                              f"{'yes' if agree else 'NO: ' + value}")
+
+    if mismatches:
+        print(f"\n{mismatches} result(s) disagree with the Python reference or failed to run")
+        return 1
+    print("\nAll implementations agree with the Python reference")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,317 +1,3517 @@
+#ifndef MULTIPARADIGM_C_INCLUDED
+#define MULTIPARADIGM_C_INCLUDED
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <math.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>  // AVX2/AVX-512 kernels, selected at run time
+#endif
 
-#define MAX_DATA_SIZE 1000
+#define MAX_DATA_SIZE 1000      // Buffer size used by the examples below
+#define INLINE_VALUES 16  // Values held in the calculator itself before spilling to the heap
 #define CACHE_SIZE 10
+#define CACHE_LINE_SIZE 64
 
+// The first CACHE_LINE_SIZE bytes hold what every query and append touches:
+// the count, the cache flags and the cached results. Buffers follow, then the
+// inline values; the data itself, once spilled, lives in separate allocations.
 typedef struct {
-    int data[MAX_DATA_SIZE];
     int count;
-    int sorted_data[MAX_DATA_SIZE];
-    int sorted_count;
+    int cache_flags;  // Bitwise flags for cached values
+    uint64_t version;  // Bumped on every change to the data; never 0
+    long long cache_sum;
     float cache_mean;
     float cache_median;
-    int cache_mode[MAX_DATA_SIZE];
-    int cache_mode_count;
     float cache_std_dev_sample;
     float cache_std_dev_population;
     int cache_range;
-    int cache_flags;  // Bitwise flags for cached values
+    int cache_min;
+    int cache_max;
+    int cache_mode_count;
+    int* cache_mode;
+    int* data;           // inline_values until the data outgrows them
+    int* sorted_data;    // Same buffer as data when the values arrived in order
+    int* histogram;      // Count per value from histogram_base, while the range is narrow
+    int capacity;
+    int sorted_count;
+    int histogram_base;
+    int histogram_span;  // Allocated bins
+    int inline_values[INLINE_VALUES];
 } StatisticsCalculator;
 
-// Cache flags
+_Static_assert(offsetof(StatisticsCalculator, cache_mode) + sizeof(int*) <= CACHE_LINE_SIZE,
+               "Cached results must share the first cache line");
+
+// Cache flags, one per node of the dependency graph (CACHE_GRAPH below)
 #define CACHE_MEAN              0x01
 #define CACHE_MEDIAN            0x02
 #define CACHE_MODE              0x04
 #define CACHE_STD_DEV_SAMPLE    0x08
 #define CACHE_STD_DEV_POPULATION 0x10
 #define CACHE_RANGE             0x20
+#define CACHE_SUM               0x40
+#define CACHE_MIN               0x80
+#define CACHE_MAX               0x100
+#define CACHE_SORTED            0x200  // sorted_data holds all values in order
+#define CACHE_VALUES            0x400  // Graph input standing for the data itself
+#define CACHE_HISTOGRAM         0x800  // histogram counts all values; kept up at ingest
+
+#define HISTOGRAM_MAX_SPAN 4096  // Widest value range tracked as dense counts
+#define COUNTING_SORT_MAX_SPAN (1 << 24)  // Bounds its temporary bins at 64 MB
+#define SMALL_NETWORK_MAX 16  // Largest size with a sorting network
+
+// Crossovers the sort and median dispatch consults. These defaults hold until
+// tune_thresholds() measures the host or loads an earlier measurement.
+typedef struct {
+    int sort_backend;           // SORT_BACKEND_* for comparison sorts, or -1 for the widest supported
+    int counting_sort_percent;  // Counting sort while max - min + 1 <= n * percent / 100
+    int run_merge_max_runs;     // Merge existing runs while there are at most this many
+    int small_network_max;      // Networks sort and take medians up to this many values
+} TuningThresholds;
+
+static TuningThresholds tuning = {-1, 100, 64, SMALL_NETWORK_MAX};
+#define CACHE_PERSISTED         0x3F   // Flags stored in checkpoints
 
 // Function declarations
 StatisticsCalculator* create_calculator(void);
 void init_calculator(StatisticsCalculator* calc);
+int reserve_capacity(StatisticsCalculator* calc, int capacity);
 void add_value(StatisticsCalculator* calc, int value);
-void add_values(StatisticsCalculator* calc, int values[], int count);
+void add_values(StatisticsCalculator* calc, const int values[], int count);
 void clear_data(StatisticsCalculator* calc);
 void sort_data(StatisticsCalculator* calc);
+int require_statistics(StatisticsCalculator* calc, int flags);
+void invalidate_cache(StatisticsCalculator* calc, int changed, int kept);
+long long calculate_sum(StatisticsCalculator* calc);
 float calculate_mean(StatisticsCalculator* calc);
 float calculate_median(StatisticsCalculator* calc);
+float calculate_percentile(StatisticsCalculator* calc, float percentile);
+double calculate_median_double(StatisticsCalculator* calc);
+double calculate_percentile_double(StatisticsCalculator* calc, double percentile);
+int calculate_median_exact(StatisticsCalculator* calc, long long* twice_median);
+int calculate_small_medians(StatisticsCalculator* const calcs[], int count, double medians[]);
+int tune_thresholds(const char* path, int force);
+int calculate_percentile_exact(StatisticsCalculator* calc, double percentile, long long* twice_value);
+int64_t select_int64(int64_t values[], size_t count, size_t k);
+int median_int64(int64_t values[], size_t count, int64_t* lower, int64_t* upper);
+double percentile_int64(int64_t values[], size_t count, double percentile);
 void calculate_mode(StatisticsCalculator* calc, int modes[], int* mode_count);
+int calculate_top_k(StatisticsCalculator* calc, int k, int values[], int counts[]);
 float calculate_std_dev(StatisticsCalculator* calc, int population);
 int calculate_range(StatisticsCalculator* calc);
 void print_summary(StatisticsCalculator* calc);
+size_t summary_to_json(StatisticsCalculator* calc, char* buffer, size_t size);
+size_t summary_to_binary(StatisticsCalculator* calc, void* buffer, size_t size);
+int format_int(char* out, long long value);
+int format_float(char* out, float value);
+uint64_t calculator_version(const StatisticsCalculator* calc);
+int calculator_changed(const StatisticsCalculator* calc, uint64_t* known_version);
+int calculate_mean_if_changed(StatisticsCalculator* calc, uint64_t* known_version, float* mean);
+int calculate_median_if_changed(StatisticsCalculator* calc, uint64_t* known_version, float* median);
+int calculate_percentile_if_changed(StatisticsCalculator* calc, float percentile, uint64_t* known_version,
+                                    float* value);
+int calculate_mode_if_changed(StatisticsCalculator* calc, uint64_t* known_version, int modes[], int* mode_count);
+int calculate_std_dev_if_changed(StatisticsCalculator* calc, int population, uint64_t* known_version,
+                                 float* std_dev);
+int calculate_range_if_changed(StatisticsCalculator* calc, uint64_t* known_version, int* range);
 void free_calculator(StatisticsCalculator* calc);
+int save_calculator(const StatisticsCalculator* calc, const char* path);
+StatisticsCalculator* load_calculator(const char* path);
 
 // Comparator for qsort
 int compare_ints(const void* a, const void* b) {
-    return *(int*)a - *(int*)b;
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);  // Subtraction overflows on wide ranges
+}
+
+// Create and initialize a new calculator
+StatisticsCalculator* create_calculator(void) {
+    StatisticsCalculator* calc = (StatisticsCalculator*)malloc(sizeof(StatisticsCalculator));
+    if (calc == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    init_calculator(calc);
+    return calc;
+}
+
+// Initialize calculator data
+void init_calculator(StatisticsCalculator* calc) {
+    calc->data = calc->inline_values;
+    calc->count = 0;
+    calc->capacity = INLINE_VALUES;
+    calc->sorted_data = NULL;
+    calc->sorted_count = 0;
+    calc->cache_mode = NULL;
+    calc->cache_mode_count = 0;
+    calc->histogram = NULL;
+    calc->histogram_base = 0;
+    calc->histogram_span = 0;
+    calc->cache_flags = 0;
+    calc->version = 1;
+}
+
+// Whether the sorted data is the data buffer itself rather than a copy
+static int sorted_shares_data(const StatisticsCalculator* calc) {
+    return calc->sorted_data != NULL && calc->sorted_data == calc->data;
+}
+
+// Grow the data buffer to hold at least `capacity` values, moving them out of
+// the inline buffer the first time
+int reserve_capacity(StatisticsCalculator* calc, int capacity) {
+    if (capacity <= calc->capacity) {
+        return 0;
+    }
+    int new_capacity = calc->capacity;
+    while (new_capacity < capacity) {
+        new_capacity = new_capacity > INT_MAX / 2 ? INT_MAX : new_capacity * 2;
+    }
+    int shared = sorted_shares_data(calc);
+    int spilling = calc->data == calc->inline_values;
+    int* data = (int*)realloc(spilling ? NULL : calc->data, (size_t)new_capacity * sizeof(int));
+    if (data == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    if (spilling) {
+        memcpy(data, calc->inline_values, (size_t)calc->count * sizeof(int));
+    }
+    calc->data = data;
+    if (shared) {
+        calc->sorted_data = data;
+    }
+    calc->capacity = new_capacity;
+    return 0;
+}
+
+// Each cached statistic and what it is computed from, listed inputs first.
+// CACHE_VALUES stands for the data itself and is never cached. A node with an
+// alternative is computed from that instead whenever it is already cached.
+// The histogram is never computed on demand; cache_append() maintains it.
+typedef struct {
+    int flag;
+    int inputs;
+    int alternative;
+} CacheNode;
+
+static const CacheNode CACHE_GRAPH[] = {
+    {CACHE_HISTOGRAM, CACHE_VALUES, 0},
+    {CACHE_SORTED, CACHE_VALUES, 0},
+    {CACHE_SUM, CACHE_VALUES, 0},
+    {CACHE_MIN, CACHE_VALUES, 0},
+    {CACHE_MAX, CACHE_VALUES, 0},
+    {CACHE_MEAN, CACHE_SUM, 0},
+    {CACHE_STD_DEV_SAMPLE, CACHE_VALUES | CACHE_SUM, 0},
+    {CACHE_STD_DEV_POPULATION, CACHE_VALUES | CACHE_SUM, 0},
+    {CACHE_MEDIAN, CACHE_SORTED, CACHE_HISTOGRAM},
+    {CACHE_MODE, CACHE_SORTED, CACHE_HISTOGRAM},
+    {CACHE_RANGE, CACHE_MIN | CACHE_MAX, 0},
+};
+
+#define CACHE_GRAPH_SIZE ((int)(sizeof(CACHE_GRAPH) / sizeof(CACHE_GRAPH[0])))
+
+// Drop every cached statistic that depends, directly or through other
+// statistics, on something in `changed`. Nodes in `kept` were updated in place
+// by the caller and stay valid; they belong in `changed` if their value moved.
+void invalidate_cache(StatisticsCalculator* calc, int changed, int kept) {
+    if (changed & CACHE_VALUES) {
+        calc->version++;
+    }
+    for (int i = 0; i < CACHE_GRAPH_SIZE; i++) {
+        if (((CACHE_GRAPH[i].inputs | CACHE_GRAPH[i].alternative) & changed) && !(CACHE_GRAPH[i].flag & kept)) {
+            calc->cache_flags &= ~CACHE_GRAPH[i].flag;
+            changed |= CACHE_GRAPH[i].flag;
+        }
+    }
+    if (!(calc->cache_flags & CACHE_SORTED)) {
+        calc->sorted_count = 0;
+    }
+}
+
+// Count appended values into the histogram, moving or growing it to cover
+// them; -1 (histogram dropped) once the range outgrows HISTOGRAM_MAX_SPAN
+static int histogram_append(StatisticsCalculator* calc, const int values[], int count, int min, int max,
+                            int fresh) {
+    long long base = calc->histogram_base;
+    long long span = calc->histogram_span;
+    if (fresh || min < base || max >= base + span) {
+        long long low = min, high = max;
+        int first = 0, last = -1;
+        if (!fresh) {
+            // Widen to the values already counted, not the headroom around them
+            last = (int)span - 1;
+            while (calc->histogram[first] == 0) first++;
+            while (calc->histogram[last] == 0) last--;
+            low = low < base + first ? low : base + first;
+            high = high > base + last ? high : base + last;
+        }
+        if (high - low >= HISTOGRAM_MAX_SPAN) {
+            return -1;
+        }
+        if (fresh && low >= base && high < base + span) {
+            memset(calc->histogram, 0, (size_t)span * sizeof(int));  // Reuse the bins after clear_data
+        } else {
+            // Headroom on both sides, so drifting values reallocate rarely
+            long long grown = 2 * (high - low + 1);
+            grown = grown < 64 ? 64 : grown > HISTOGRAM_MAX_SPAN ? HISTOGRAM_MAX_SPAN : grown;
+            long long grown_base = low - (grown - (high - low + 1)) / 2;
+            grown_base = grown_base < INT_MIN ? INT_MIN : grown_base;
+            grown_base = grown_base > (long long)INT_MAX - grown + 1 ? (long long)INT_MAX - grown + 1 : grown_base;
+            int* bins = (int*)calloc((size_t)grown, sizeof(int));
+            if (bins == NULL) {
+                return -1;
+            }
+            if (last >= first) {
+                memcpy(bins + (base + first - grown_base), calc->histogram + first,
+                       (size_t)(last - first + 1) * sizeof(int));
+            }
+            free(calc->histogram);
+            calc->histogram = bins;
+            calc->histogram_base = (int)grown_base;
+            calc->histogram_span = (int)grown;
+        }
+    }
+    int* bins = calc->histogram;
+    int offset = calc->histogram_base;
+    for (int i = 0; i < count; i++) {
+        bins[values[i] - offset]++;
+    }
+    return 0;
+}
+
+// Update the cache for `count` values just appended. The sum, min, max,
+// histogram and sorted data are carried forward when cached (the sorted data
+// only if the new values extend it in order), so e.g. the range survives an
+// append of values inside [min, max]. The append that takes the data past
+// INLINE_VALUES starts the histogram, so small calculators allocate nothing.
+static void cache_append(StatisticsCalculator* calc, const int values[], int count) {
+    int flags = calc->cache_flags;
+    int changed = CACHE_VALUES | CACHE_SUM | CACHE_SORTED | CACHE_MIN | CACHE_MAX | CACHE_HISTOGRAM;
+    int kept = 0;
+    int before = calc->count - count;
+    int fresh = before <= INLINE_VALUES && calc->count > INLINE_VALUES;
+    if (flags & (CACHE_SUM | CACHE_MIN | CACHE_MAX | CACHE_HISTOGRAM) || fresh) {
+        long long sum = 0;
+        int min = values[0], max = values[0];
+        for (int i = 0; i < count; i++) {
+            sum += values[i];
+            min = values[i] < min ? values[i] : min;
+            max = values[i] > max ? values[i] : max;
+        }
+        if (flags & CACHE_SUM) {
+            calc->cache_sum += sum;
+            kept |= CACHE_SUM;
+        }
+        if (flags & CACHE_MIN) {
+            kept |= CACHE_MIN;
+            if (min < calc->cache_min) {
+                calc->cache_min = min;
+            } else {
+                changed &= ~CACHE_MIN;
+            }
+        }
+        if (flags & CACHE_MAX) {
+            kept |= CACHE_MAX;
+            if (max > calc->cache_max) {
+                calc->cache_max = max;
+            } else {
+                changed &= ~CACHE_MAX;
+            }
+        }
+        if (fresh) {
+            // The histogram also counts the values held back while the calculator was small
+            for (int i = 0; i < before; i++) {
+                min = calc->data[i] < min ? calc->data[i] : min;
+                max = calc->data[i] > max ? calc->data[i] : max;
+            }
+        }
+        const int* counted = fresh ? calc->data : values;
+        int counted_count = fresh ? calc->count : count;
+        if (((flags & CACHE_HISTOGRAM) || fresh) &&
+            histogram_append(calc, counted, counted_count, min, max, fresh) == 0) {
+            kept |= CACHE_HISTOGRAM;
+            calc->cache_flags |= CACHE_HISTOGRAM;
+        }
+    }
+    if (flags & CACHE_SORTED) {
+        int in_order = values[0] >= calc->sorted_data[calc->sorted_count - 1];
+        for (int i = 1; i < count && in_order; i++) {
+            in_order = values[i] >= values[i - 1];
+        }
+        if (in_order && sorted_shares_data(calc)) {
+            calc->sorted_count += count;  // The data buffer already ends with the new values
+            kept |= CACHE_SORTED;
+            in_order = 0;
+        }
+        int* sorted = in_order ? (int*)realloc(calc->sorted_data,
+                                               (size_t)(calc->sorted_count + count) * sizeof(int)) : NULL;
+        if (sorted != NULL) {
+            memcpy(sorted + calc->sorted_count, values, (size_t)count * sizeof(int));
+            calc->sorted_data = sorted;
+            calc->sorted_count += count;
+            kept |= CACHE_SORTED;
+        }
+    }
+    invalidate_cache(calc, changed, kept);
+}
+
+// Modes collected while the sorted data is scanned run by run
+typedef struct {
+    int* modes;
+    int count;
+    int capacity;
+    int max_freq;
+} ModeScan;
+
+// Account for one run of `length` copies of `value`; -1 if out of memory
+static inline int mode_scan_run(ModeScan* scan, int value, int length) {
+    if (length < scan->max_freq) {
+        return 0;
+    }
+    if (length > scan->max_freq) {
+        scan->max_freq = length;
+        scan->count = 0;
+    }
+    if (scan->count == scan->capacity) {
+        int capacity = scan->capacity * 2;
+        int* modes = (int*)realloc(scan->modes, (size_t)capacity * sizeof(int));
+        if (modes == NULL) {
+            return -1;
+        }
+        scan->modes = modes;
+        scan->capacity = capacity;
+    }
+    scan->modes[scan->count++] = value;
+    return 0;
+}
+
+// Scan sorted[1..n) for run boundaries (sorted[i] != sorted[i-1]); returns
+// where the scan stopped and the start of the still-open run in *run_start
+static int scan_runs_scalar(ModeScan* scan, const int* sorted, int n, int i, int* run_start) {
+    for (; i < n; i++) {
+        if (sorted[i] != sorted[i - 1]) {
+            if (mode_scan_run(scan, sorted[i - 1], i - *run_start) != 0) {
+                return -1;
+            }
+            *run_start = i;
+        }
+    }
+    return i;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// Compare 8 neighbours at a time and visit only the boundaries in the mask. A
+// block of 8 boundaries with max_freq > 1 holds 7 runs of one, which cannot be
+// modes, so only the run it closes needs a look.
+__attribute__((target("avx2")))
+static int scan_runs_avx2(ModeScan* scan, const int* sorted, int n, int i, int* run_start) {
+    for (; i + 8 <= n; i += 8) {
+        __m256i current = _mm256_loadu_si256((const __m256i*)(sorted + i));
+        __m256i previous = _mm256_loadu_si256((const __m256i*)(sorted + i - 1));
+        unsigned same = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(current, previous)));
+        unsigned boundaries = ~same & 0xFF;
+        if (boundaries == 0) {
+            continue;
+        }
+        if (boundaries == 0xFF && scan->max_freq > 1) {
+            if (mode_scan_run(scan, sorted[i - 1], i - *run_start) != 0) {
+                return -1;
+            }
+            *run_start = i + 7;
+            continue;
+        }
+        do {
+            int at = i + __builtin_ctz(boundaries);
+            if (mode_scan_run(scan, sorted[at - 1], at - *run_start) != 0) {
+                return -1;
+            }
+            *run_start = at;
+            boundaries &= boundaries - 1;
+        } while (boundaries != 0);
+    }
+    return i;
+}
+#endif
+
+// Collect all modes of the sorted data in one pass into calc->cache_mode
+static int scan_modes(StatisticsCalculator* calc) {
+    const int* sorted = calc->sorted_data;
+    int n = calc->count;
+    ModeScan scan = {(int*)realloc(calc->cache_mode, 16 * sizeof(int)), 0, 16, 0};
+    if (scan.modes == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    int run_start = 0;
+    int i = 1;
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) {
+        i = scan_runs_avx2(&scan, sorted, n, i, &run_start);
+    }
+#endif
+    if (i >= 0) {
+        i = scan_runs_scalar(&scan, sorted, n, i, &run_start);
+    }
+    calc->cache_mode = scan.modes;
+    if (i < 0 || mode_scan_run(&scan, sorted[n - 1], n - run_start) != 0) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    calc->cache_mode = scan.modes;
+    calc->cache_mode_count = scan.count;
+    return 0;
+}
+
+// Modes straight from the histogram, already in increasing order
+static int histogram_modes(StatisticsCalculator* calc) {
+    const int* bins = calc->histogram;
+    int max_freq = 0;
+    int mode_count = 0;
+    for (int i = 0; i < calc->histogram_span; i++) {
+        if (bins[i] > max_freq) {
+            max_freq = bins[i];
+            mode_count = 1;
+        } else if (bins[i] == max_freq) {
+            mode_count++;
+        }
+    }
+    int* modes = (int*)realloc(calc->cache_mode, (size_t)mode_count * sizeof(int));
+    if (modes == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    calc->cache_mode = modes;
+    calc->cache_mode_count = 0;
+    for (int i = 0; i < calc->histogram_span; i++) {
+        if (bins[i] == max_freq) {
+            modes[calc->cache_mode_count++] = calc->histogram_base + i;
+        }
+    }
+    return 0;
+}
+
+// The values at sorted positions `rank` and `rank + 1` (clamped to the last),
+// from the sorted data or else an O(range) walk of the histogram
+static void values_at_rank(const StatisticsCalculator* calc, int rank, int* value, int* next) {
+    int following = rank < calc->count - 1 ? rank + 1 : rank;
+    if (calc->cache_flags & CACHE_SORTED) {
+        *value = calc->sorted_data[rank];
+        *next = calc->sorted_data[following];
+        return;
+    }
+    const int* bins = calc->histogram;
+    long long seen = 0;
+    int i = 0;
+    while (seen + bins[i] <= rank) {
+        seen += bins[i++];
+    }
+    *value = calc->histogram_base + i;
+    while (seen + bins[i] <= following) {
+        seen += bins[i++];
+    }
+    *next = calc->histogram_base + i;
+}
+
+// Write the values counted in bins[0..span) out in order
+static void expand_counts(int* out, const int* bins, int base, int span) {
+    for (int i = 0; i < span; i++) {
+        for (int c = bins[i]; c > 0; c--) {
+            *out++ = base + i;
+        }
+    }
+}
+
+// Sort values known to lie in [min, max] with one counting pass and one
+// expansion pass. Returns -1 if the bins cannot be allocated.
+static int counting_sort(int* out, const int* values, int count, int min, int max) {
+    int span = max - min + 1;
+    int* bins = (int*)calloc((size_t)span, sizeof(int));
+    if (bins == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        bins[values[i] - min]++;
+    }
+    expand_counts(out, bins, min, span);
+    free(bins);
+    return 0;
+}
+
+// End of the run starting at `start`: non-decreasing, or strictly decreasing
+static int run_end(const int* values, int start, int n) {
+    int i = start + 1;
+    if (i < n && values[i] < values[i - 1]) {
+        while (i < n && values[i] < values[i - 1]) {
+            i++;
+        }
+    } else {
+        while (i < n && values[i] >= values[i - 1]) {
+            i++;
+        }
+    }
+    return i;
+}
+
+// Number of runs in values[0..n), or anything above `limit` once it is exceeded
+static int count_runs(const int* values, int n, int limit) {
+    int runs = 0;
+    for (int start = 0; start < n && runs <= limit; runs++) {
+        start = run_end(values, start, n);
+    }
+    return runs;
+}
+
+// Merge the ordered ranges in[lo..mid) and in[mid..hi) into out[lo..hi)
+static void merge_pair(int* out, const int* in, int lo, int mid, int hi) {
+    if (mid == hi || in[mid - 1] <= in[mid]) {
+        memcpy(out + lo, in + lo, (size_t)(hi - lo) * sizeof(int));
+        return;
+    }
+    int i = lo, j = mid, k = lo;
+    while (i < mid && j < hi) {
+        out[k++] = in[j] < in[i] ? in[j++] : in[i++];
+    }
+    memcpy(out + k, in + i, (size_t)(mid - i) * sizeof(int));
+    k += mid - i;
+    memcpy(out + k, in + j, (size_t)(hi - j) * sizeof(int));
+}
+
+// Natural merge sort of values made of `runs` runs (see count_runs): copy them
+// into `out` with the descending runs reversed, then merge neighbouring runs
+// pairwise, O(n log runs) in all. Returns -1 if memory runs out.
+static int merge_runs(int* out, const int* values, int n, int runs) {
+    int* bounds = (int*)malloc((size_t)(runs + 1) * sizeof(int));
+    int* buffer = runs > 1 ? (int*)malloc((size_t)n * sizeof(int)) : NULL;
+    if (bounds == NULL || (runs > 1 && buffer == NULL)) {
+        free(bounds);
+        free(buffer);
+        return -1;
+    }
+    runs = 0;
+    for (int start = 0; start < n;) {
+        int end = run_end(values, start, n);
+        if (values[end - 1] < values[start]) {
+            for (int i = start; i < end; i++) {
+                out[i] = values[start + end - 1 - i];
+            }
+        } else {
+            memcpy(out + start, values + start, (size_t)(end - start) * sizeof(int));
+        }
+        bounds[runs++] = start;
+        start = end;
+    }
+    bounds[runs] = n;
+
+    int* from = out;
+    int* to = buffer;
+    while (runs > 1) {
+        int merged = 0;
+        for (int r = 0; r < runs; r += 2) {
+            int hi = r + 2 <= runs ? bounds[r + 2] : n;
+            merge_pair(to, from, bounds[r], bounds[r + 1], hi);
+            bounds[merged++] = bounds[r];
+        }
+        bounds[merged] = n;
+        runs = merged;
+        int* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != out) {
+        memcpy(out, from, (size_t)n * sizeof(int));
+    }
+    free(bounds);
+    free(buffer);
+    return 0;
+}
+
+// Whether [min, max] is narrow enough for counting sort to beat a comparison sort on n values
+static int counting_sort_fits(int min, int max, int n) {
+    long long span = (long long)max - min + 1;
+    return span <= COUNTING_SORT_MAX_SPAN && span * 100 <= (long long)n * tuning.counting_sort_percent;
+}
+
+// Sorting networks for 2..16 values: Batcher's odd-even merge sort written out
+// as comparator lists (generated, and checked against every 0/1 input). An
+// X-macro expands a list into straight-line compare-exchanges, so the median
+// variants keep only the comparators that feed the middle positions.
+#define NETWORK_2(X) X(0, 1)
+#define NETWORK_3(X) X(0, 1) X(0, 2) X(1, 2)
+#define NETWORK_4(X) X(0, 1) X(2, 3) X(0, 2) X(1, 3) X(1, 2)
+#define NETWORK_5(X) X(0, 1) X(2, 3) X(0, 2) X(1, 3) X(1, 2) X(0, 4) X(2, 4) X(1, 2) X(3, 4)
+#define NETWORK_6(X) X(0, 1) X(2, 3) X(4, 5) X(0, 2) X(1, 3) X(1, 2) X(0, 4) X(1, 5) X(2, 4) X(3, 5) X(1, 2) \
+    X(3, 4)
+#define NETWORK_7(X) X(0, 1) X(2, 3) X(4, 5) X(0, 2) X(1, 3) X(4, 6) X(1, 2) X(5, 6) X(0, 4) X(1, 5) X(2, 6) \
+    X(2, 4) X(3, 5) X(1, 2) X(3, 4) X(5, 6)
+#define NETWORK_8(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(1, 2) X(5, 6) X(0, 4) \
+    X(1, 5) X(2, 6) X(3, 7) X(2, 4) X(3, 5) X(1, 2) X(3, 4) X(5, 6)
+#define NETWORK_9(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(1, 2) X(5, 6) X(0, 4) \
+    X(1, 5) X(2, 6) X(3, 7) X(2, 4) X(3, 5) X(1, 2) X(3, 4) X(5, 6) X(0, 8) X(4, 8) X(2, 4) X(3, 5) X(6, 8) \
+    X(1, 2) X(3, 4) X(5, 6) X(7, 8)
+#define NETWORK_10(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(1, 2) X(5, 6) \
+    X(0, 4) X(1, 5) X(2, 6) X(3, 7) X(2, 4) X(3, 5) X(1, 2) X(3, 4) X(5, 6) X(0, 8) X(1, 9) X(4, 8) X(5, 9) \
+    X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(1, 2) X(3, 4) X(5, 6) X(7, 8)
+#define NETWORK_11(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(0, 2) X(1, 3) X(4, 6) X(5, 7) X(8, 10) X(1, 2) \
+    X(5, 6) X(9, 10) X(0, 4) X(1, 5) X(2, 6) X(3, 7) X(2, 4) X(3, 5) X(1, 2) X(3, 4) X(5, 6) X(9, 10) X(0, 8) \
+    X(1, 9) X(2, 10) X(4, 8) X(5, 9) X(6, 10) X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(1, 2) X(3, 4) X(5, 6) X(7, 8) \
+    X(9, 10)
+#define NETWORK_12(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(0, 2) X(1, 3) X(4, 6) X(5, 7) \
+    X(8, 10) X(9, 11) X(1, 2) X(5, 6) X(9, 10) X(0, 4) X(1, 5) X(2, 6) X(3, 7) X(2, 4) X(3, 5) X(1, 2) X(3, 4) \
+    X(5, 6) X(9, 10) X(0, 8) X(1, 9) X(2, 10) X(3, 11) X(4, 8) X(5, 9) X(6, 10) X(7, 11) X(2, 4) X(3, 5) \
+    X(6, 8) X(7, 9) X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10)
+#define NETWORK_13(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(0, 2) X(1, 3) X(4, 6) X(5, 7) \
+    X(8, 10) X(9, 11) X(1, 2) X(5, 6) X(9, 10) X(0, 4) X(1, 5) X(2, 6) X(3, 7) X(8, 12) X(2, 4) X(3, 5) \
+    X(10, 12) X(1, 2) X(3, 4) X(5, 6) X(9, 10) X(11, 12) X(0, 8) X(1, 9) X(2, 10) X(3, 11) X(4, 12) X(4, 8) \
+    X(5, 9) X(6, 10) X(7, 11) X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(10, 12) X(1, 2) X(3, 4) X(5, 6) X(7, 8) \
+    X(9, 10) X(11, 12)
+#define NETWORK_14(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(12, 13) X(0, 2) X(1, 3) X(4, 6) \
+    X(5, 7) X(8, 10) X(9, 11) X(1, 2) X(5, 6) X(9, 10) X(0, 4) X(1, 5) X(2, 6) X(3, 7) X(8, 12) X(9, 13) \
+    X(2, 4) X(3, 5) X(10, 12) X(11, 13) X(1, 2) X(3, 4) X(5, 6) X(9, 10) X(11, 12) X(0, 8) X(1, 9) X(2, 10) \
+    X(3, 11) X(4, 12) X(5, 13) X(4, 8) X(5, 9) X(6, 10) X(7, 11) X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(10, 12) \
+    X(11, 13) X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10) X(11, 12)
+#define NETWORK_15(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(12, 13) X(0, 2) X(1, 3) X(4, 6) \
+    X(5, 7) X(8, 10) X(9, 11) X(12, 14) X(1, 2) X(5, 6) X(9, 10) X(13, 14) X(0, 4) X(1, 5) X(2, 6) X(3, 7) \
+    X(8, 12) X(9, 13) X(10, 14) X(2, 4) X(3, 5) X(10, 12) X(11, 13) X(1, 2) X(3, 4) X(5, 6) X(9, 10) X(11, 12) \
+    X(13, 14) X(0, 8) X(1, 9) X(2, 10) X(3, 11) X(4, 12) X(5, 13) X(6, 14) X(4, 8) X(5, 9) X(6, 10) X(7, 11) \
+    X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(10, 12) X(11, 13) X(1, 2) X(3, 4) X(5, 6) X(7, 8) X(9, 10) X(11, 12) \
+    X(13, 14)
+#define NETWORK_16(X) X(0, 1) X(2, 3) X(4, 5) X(6, 7) X(8, 9) X(10, 11) X(12, 13) X(14, 15) X(0, 2) X(1, 3) \
+    X(4, 6) X(5, 7) X(8, 10) X(9, 11) X(12, 14) X(13, 15) X(1, 2) X(5, 6) X(9, 10) X(13, 14) X(0, 4) X(1, 5) \
+    X(2, 6) X(3, 7) X(8, 12) X(9, 13) X(10, 14) X(11, 15) X(2, 4) X(3, 5) X(10, 12) X(11, 13) X(1, 2) X(3, 4) \
+    X(5, 6) X(9, 10) X(11, 12) X(13, 14) X(0, 8) X(1, 9) X(2, 10) X(3, 11) X(4, 12) X(5, 13) X(6, 14) X(7, 15) \
+    X(4, 8) X(5, 9) X(6, 10) X(7, 11) X(2, 4) X(3, 5) X(6, 8) X(7, 9) X(10, 12) X(11, 13) X(1, 2) X(3, 4) \
+    X(5, 6) X(7, 8) X(9, 10) X(11, 12) X(13, 14)
+#define NETWORK_SIZES(CASE) CASE(2) CASE(3) CASE(4) CASE(5) CASE(6) CASE(7) CASE(8) CASE(9) \
+    CASE(10) CASE(11) CASE(12) CASE(13) CASE(14) CASE(15) CASE(16)
+
+#define NETWORK_EXCHANGE(i, j) { \
+    int a = v[i], b = v[j];      \
+    v[i] = a < b ? a : b;        \
+    v[j] = a < b ? b : a;        \
+}
+
+// Sort n <= SMALL_NETWORK_MAX values in place, free of branches on the data
+static void network_sort(int* v, int n) {
+    switch (n) {
+#define NETWORK_SORT_CASE(n) case n: NETWORK_##n(NETWORK_EXCHANGE) break;
+    NETWORK_SIZES(NETWORK_SORT_CASE)
+#undef NETWORK_SORT_CASE
+    }
+}
+
+// Lower and upper middle of n <= SMALL_NETWORK_MAX values, without sorting them
+static void network_median(const int* values, int n, int* lower, int* upper) {
+    int v[SMALL_NETWORK_MAX];
+    switch (n) {
+#define NETWORK_MEDIAN_CASE(n)                  \
+    case n:                                     \
+        memcpy(v, values, n * sizeof(int));     \
+        NETWORK_##n(NETWORK_EXCHANGE)           \
+        *lower = v[(n - 1) / 2];                \
+        *upper = v[n / 2];                      \
+        return;
+    NETWORK_SIZES(NETWORK_MEDIAN_CASE)
+#undef NETWORK_MEDIAN_CASE
+    }
+    *lower = *upper = values[0];
+}
+
+// The same median networks run on 8 calculators of one size at once, one per
+// vector lane; GCC lowers the vector type to whatever the target offers
+typedef int NetworkLanes __attribute__((vector_size(32)));
+#define NETWORK_LANES 8
+
+#define NETWORK_LANE_EXCHANGE(i, j) {            \
+    NetworkLanes a = v[i], b = v[j], less = a < b; \
+    v[i] = (a & less) | (b & ~less);             \
+    v[j] = (b & less) | (a & ~less);             \
+}
+
+static inline __attribute__((always_inline))
+void lane_medians(StatisticsCalculator* const group[], int n, double medians[]) {
+    NetworkLanes v[SMALL_NETWORK_MAX];
+    for (int i = 0; i < n; i++) {
+        for (int lane = 0; lane < NETWORK_LANES; lane++) {
+            v[i][lane] = group[lane]->data[i];
+        }
+    }
+    NetworkLanes lower, upper;
+    switch (n) {
+#define NETWORK_LANE_CASE(n)                    \
+    case n:                                     \
+        NETWORK_##n(NETWORK_LANE_EXCHANGE)      \
+        lower = v[(n - 1) / 2];                 \
+        upper = v[n / 2];                       \
+        break;
+    NETWORK_SIZES(NETWORK_LANE_CASE)
+#undef NETWORK_LANE_CASE
+    default:
+        lower = upper = v[0];
+        break;
+    }
+    for (int lane = 0; lane < NETWORK_LANES; lane++) {
+        medians[lane] = ((double)lower[lane] + upper[lane]) / 2.0;
+    }
+}
+
+static void lane_medians_generic(StatisticsCalculator* const group[], int n, double medians[]) {
+    lane_medians(group, n, medians);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("avx2")))
+static void lane_medians_avx2(StatisticsCalculator* const group[], int n, double medians[]) {
+    lane_medians(group, n, medians);
+}
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// Vectorised quicksort. Each level partitions around a sampled pivot with one
+// vector compare per 8 or 16 values, writing both sides in place from the
+// ends of the range; partitions small enough for two registers finish in a
+// bitonic sorting network. Too many lopsided splits hand over to qsort.
+typedef struct {
+    int small;                               // Largest n sort_small() handles
+    void (*sort_small)(int* values, int n);
+    int (*partition)(int* values, int n, int pivot);  // n > small; returns the count <= pivot
+} SimdSorter;
+
+// Median of three samples, or of three such medians on larger ranges
+static int median_of_three(int a, int b, int c) {
+    return a < b ? (b < c ? b : a < c ? c : a) : (a < c ? a : b < c ? c : b);
+}
+
+static int choose_pivot(const int* values, int n) {
+    int step = n / 8;
+    if (n < 128) {
+        return median_of_three(values[0], values[n / 2], values[n - 1]);
+    }
+    return median_of_three(median_of_three(values[0], values[step], values[2 * step]),
+                           median_of_three(values[3 * step], values[n / 2], values[5 * step]),
+                           median_of_three(values[6 * step], values[7 * step], values[n - 1]));
+}
+
+static void simd_quicksort(const SimdSorter* sorter, int* values, int n, int depth) {
+    while (n > sorter->small) {
+        if (depth-- == 0) {
+            qsort(values, n, sizeof(int), compare_ints);
+            return;
+        }
+        int pivot = choose_pivot(values, n);
+        int low = sorter->partition(values, n, pivot);
+        if (low == n) {
+            // The pivot is the maximum: its copies split off to the end, already in place
+            if (pivot == INT_MIN) {
+                return;
+            }
+            n = sorter->partition(values, n, pivot - 1);
+            continue;
+        }
+        // Recurse into the smaller side so the stack stays O(log n)
+        if (low < n - low) {
+            simd_quicksort(sorter, values, low, depth);
+            values += low;
+            n -= low;
+        } else {
+            simd_quicksort(sorter, values + low, n - low, depth);
+            n = low;
+        }
+    }
+    sorter->sort_small(values, n);
+}
+
+// For each mask of lanes above the pivot, the lane order that packs the
+// others first and those last, one lane index per nibble
+static const uint32_t PARTITION_PERMUTATIONS[256] = {
+    0x76543210, 0x07654321, 0x17654320, 0x10765432, 0x27654310, 0x20765431, 0x21765430, 0x21076543,
+    0x37654210, 0x30765421, 0x31765420, 0x31076542, 0x32765410, 0x32076541, 0x32176540, 0x32107654,
+    0x47653210, 0x40765321, 0x41765320, 0x41076532, 0x42765310, 0x42076531, 0x42176530, 0x42107653,
+    0x43765210, 0x43076521, 0x43176520, 0x43107652, 0x43276510, 0x43207651, 0x43217650, 0x43210765,
+    0x57643210, 0x50764321, 0x51764320, 0x51076432, 0x52764310, 0x52076431, 0x52176430, 0x52107643,
+    0x53764210, 0x53076421, 0x53176420, 0x53107642, 0x53276410, 0x53207641, 0x53217640, 0x53210764,
+    0x54763210, 0x54076321, 0x54176320, 0x54107632, 0x54276310, 0x54207631, 0x54217630, 0x54210763,
+    0x54376210, 0x54307621, 0x54317620, 0x54310762, 0x54327610, 0x54320761, 0x54321760, 0x54321076,
+    0x67543210, 0x60754321, 0x61754320, 0x61075432, 0x62754310, 0x62075431, 0x62175430, 0x62107543,
+    0x63754210, 0x63075421, 0x63175420, 0x63107542, 0x63275410, 0x63207541, 0x63217540, 0x63210754,
+    0x64753210, 0x64075321, 0x64175320, 0x64107532, 0x64275310, 0x64207531, 0x64217530, 0x64210753,
+    0x64375210, 0x64307521, 0x64317520, 0x64310752, 0x64327510, 0x64320751, 0x64321750, 0x64321075,
+    0x65743210, 0x65074321, 0x65174320, 0x65107432, 0x65274310, 0x65207431, 0x65217430, 0x65210743,
+    0x65374210, 0x65307421, 0x65317420, 0x65310742, 0x65327410, 0x65320741, 0x65321740, 0x65321074,
+    0x65473210, 0x65407321, 0x65417320, 0x65410732, 0x65427310, 0x65420731, 0x65421730, 0x65421073,
+    0x65437210, 0x65430721, 0x65431720, 0x65431072, 0x65432710, 0x65432071, 0x65432170, 0x65432107,
+    0x76543210, 0x70654321, 0x71654320, 0x71065432, 0x72654310, 0x72065431, 0x72165430, 0x72106543,
+    0x73654210, 0x73065421, 0x73165420, 0x73106542, 0x73265410, 0x73206541, 0x73216540, 0x73210654,
+    0x74653210, 0x74065321, 0x74165320, 0x74106532, 0x74265310, 0x74206531, 0x74216530, 0x74210653,
+    0x74365210, 0x74306521, 0x74316520, 0x74310652, 0x74326510, 0x74320651, 0x74321650, 0x74321065,
+    0x75643210, 0x75064321, 0x75164320, 0x75106432, 0x75264310, 0x75206431, 0x75216430, 0x75210643,
+    0x75364210, 0x75306421, 0x75316420, 0x75310642, 0x75326410, 0x75320641, 0x75321640, 0x75321064,
+    0x75463210, 0x75406321, 0x75416320, 0x75410632, 0x75426310, 0x75420631, 0x75421630, 0x75421063,
+    0x75436210, 0x75430621, 0x75431620, 0x75431062, 0x75432610, 0x75432061, 0x75432160, 0x75432106,
+    0x76543210, 0x76054321, 0x76154320, 0x76105432, 0x76254310, 0x76205431, 0x76215430, 0x76210543,
+    0x76354210, 0x76305421, 0x76315420, 0x76310542, 0x76325410, 0x76320541, 0x76321540, 0x76321054,
+    0x76453210, 0x76405321, 0x76415320, 0x76410532, 0x76425310, 0x76420531, 0x76421530, 0x76421053,
+    0x76435210, 0x76430521, 0x76431520, 0x76431052, 0x76432510, 0x76432051, 0x76432150, 0x76432105,
+    0x76543210, 0x76504321, 0x76514320, 0x76510432, 0x76524310, 0x76520431, 0x76521430, 0x76521043,
+    0x76534210, 0x76530421, 0x76531420, 0x76531042, 0x76532410, 0x76532041, 0x76532140, 0x76532104,
+    0x76543210, 0x76540321, 0x76541320, 0x76541032, 0x76542310, 0x76542031, 0x76542130, 0x76542103,
+    0x76543210, 0x76543021, 0x76543120, 0x76543102, 0x76543210, 0x76543201, 0x76543210, 0x76543210,
+};
+
+// One compare-exchange stage of a bitonic network across 8 lanes: each lane
+// meets lane ^ j and keeps the larger value where its direction asks for it
+__attribute__((target("avx2")))
+static inline __m256i bitonic_step_avx2(__m256i v, int j, int k) {
+    __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i bit_j = _mm256_set1_epi32(j);
+    __m256i bit_k = _mm256_set1_epi32(k);
+    __m256i partners = _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(lanes, bit_j));
+    __m256i take_max = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_and_si256(lanes, bit_j), bit_j),
+                                        _mm256_cmpeq_epi32(_mm256_and_si256(lanes, bit_k), bit_k));
+    return _mm256_blendv_epi8(_mm256_min_epi32(v, partners), _mm256_max_epi32(v, partners), take_max);
+}
+
+// Sort up to 16 values in two registers, padding with INT_MAX
+__attribute__((target("avx2")))
+static void sort_small_avx2(int* values, int n) {
+    if (n < 2) {
+        return;
+    }
+    __m256i padding = _mm256_set1_epi32(INT_MAX);
+    __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i mask_a = _mm256_cmpgt_epi32(_mm256_set1_epi32(n), lanes);
+    __m256i mask_b = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - 8), lanes);
+    __m256i a = _mm256_blendv_epi8(padding, _mm256_maskload_epi32(values, mask_a), mask_a);
+    __m256i b = _mm256_blendv_epi8(padding, _mm256_maskload_epi32(values + 8, mask_b), mask_b);
+    for (int k = 2; k <= 8; k *= 2) {
+        for (int j = k / 2; j > 0; j /= 2) {
+            a = bitonic_step_avx2(a, j, k);
+            b = bitonic_step_avx2(b, j, k);
+        }
+    }
+    // Against b reversed, the lower halves hold the 8 smallest; merge each half
+    __m256i reversed = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    __m256i low = _mm256_min_epi32(a, reversed);
+    __m256i high = _mm256_max_epi32(a, reversed);
+    for (int j = 4; j > 0; j /= 2) {
+        low = bitonic_step_avx2(low, j, 16);
+        high = bitonic_step_avx2(high, j, 16);
+    }
+    _mm256_maskstore_epi32(values, mask_a, low);
+    _mm256_maskstore_epi32(values + 8, mask_b, high);
+}
+
+// Pack one vector's values <= pivot at *left and the rest just below *right.
+// Both stores are full width, so each side needs 8 free slots.
+__attribute__((target("avx2,popcnt")))
+static inline void partition_store_avx2(int* values, __m256i v, __m256i pivots, int* left, int* right) {
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pivots)));
+    int greater = __builtin_popcount((unsigned)mask);
+    __m256i order = _mm256_srlv_epi32(_mm256_set1_epi32((int)PARTITION_PERMUTATIONS[mask]),
+                                      _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28));
+    v = _mm256_permutevar8x32_epi32(v, order);
+    _mm256_storeu_si256((__m256i*)(values + *left), v);
+    _mm256_storeu_si256((__m256i*)(values + *right - 8), v);
+    *left += 8 - greater;
+    *right -= greater;
+}
+
+// In-place partition of n >= 16 values. The first and last vectors are held
+// back so that 16 slots are always free between what is written and what is
+// still unread; the next load comes from the side with less room.
+__attribute__((target("avx2,popcnt")))
+static int partition_avx2(int* values, int n, int pivot) {
+    __m256i pivots = _mm256_set1_epi32(pivot);
+    __m256i first = _mm256_loadu_si256((const __m256i*)values);
+    __m256i last = _mm256_loadu_si256((const __m256i*)(values + n - 8));
+    int read_left = 8, read_right = n - 8;
+    int write_left = 0, write_right = n;
+    while (read_right - read_left >= 8) {
+        __m256i v;
+        if (read_left - write_left <= write_right - read_right) {
+            v = _mm256_loadu_si256((const __m256i*)(values + read_left));
+            read_left += 8;
+        } else {
+            read_right -= 8;
+            v = _mm256_loadu_si256((const __m256i*)(values + read_right));
+        }
+        partition_store_avx2(values, v, pivots, &write_left, &write_right);
+    }
+    int rest[8];
+    int rest_count = read_right - read_left;
+    memcpy(rest, values + read_left, (size_t)rest_count * sizeof(int));
+    for (int i = 0; i < rest_count; i++) {
+        if (rest[i] <= pivot) {
+            values[write_left++] = rest[i];
+        } else {
+            values[--write_right] = rest[i];
+        }
+    }
+    partition_store_avx2(values, first, pivots, &write_left, &write_right);
+    partition_store_avx2(values, last, pivots, &write_left, &write_right);
+    return write_left;
+}
+
+static const SimdSorter SIMD_SORTER_AVX2 = {16, sort_small_avx2, partition_avx2};
+
+// The same network across 16 lanes, with a mask register choosing the maxima
+__attribute__((target("avx512f")))
+static inline __m512i bitonic_step_avx512(__m512i v, int j, int k) {
+    __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i partners = _mm512_permutexvar_epi32(_mm512_xor_si512(lanes, _mm512_set1_epi32(j)), v);
+    __mmask16 take_max = _mm512_test_epi32_mask(lanes, _mm512_set1_epi32(j)) ^
+                         _mm512_test_epi32_mask(lanes, _mm512_set1_epi32(k));
+    return _mm512_mask_mov_epi32(_mm512_min_epi32(v, partners), take_max, _mm512_max_epi32(v, partners));
+}
+
+// Sort up to 32 values in two registers, padding with INT_MAX
+__attribute__((target("avx512f")))
+static void sort_small_avx512(int* values, int n) {
+    if (n < 2) {
+        return;
+    }
+    __m512i padding = _mm512_set1_epi32(INT_MAX);
+    __mmask16 mask_a = (__mmask16)(n >= 16 ? 0xFFFF : (1u << n) - 1);
+    __mmask16 mask_b = (__mmask16)(n <= 16 ? 0 : (1u << (n - 16)) - 1);
+    __m512i a = _mm512_mask_loadu_epi32(padding, mask_a, values);
+    __m512i b = _mm512_mask_loadu_epi32(padding, mask_b, values + 16);
+    for (int k = 2; k <= 16; k *= 2) {
+        for (int j = k / 2; j > 0; j /= 2) {
+            a = bitonic_step_avx512(a, j, k);
+            b = bitonic_step_avx512(b, j, k);
+        }
+    }
+    __m512i reversed = _mm512_permutexvar_epi32(
+        _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0), b);
+    __m512i low = _mm512_min_epi32(a, reversed);
+    __m512i high = _mm512_max_epi32(a, reversed);
+    for (int j = 8; j > 0; j /= 2) {
+        low = bitonic_step_avx512(low, j, 32);
+        high = bitonic_step_avx512(high, j, 32);
+    }
+    _mm512_mask_storeu_epi32(values, mask_a, low);
+    _mm512_mask_storeu_epi32(values + 16, mask_b, high);
+}
+
+// Compress instead of a permutation table; the greater side is a masked store
+__attribute__((target("avx512f,popcnt")))
+static inline void partition_store_avx512(int* values, __m512i v, __m512i pivots, int* left, int* right) {
+    __mmask16 greater = _mm512_cmpgt_epi32_mask(v, pivots);
+    int greater_count = __builtin_popcount((unsigned)greater);
+    _mm512_storeu_si512(values + *left, _mm512_maskz_compress_epi32((__mmask16)~greater, v));
+    _mm512_mask_storeu_epi32(values + *right - greater_count, (__mmask16)((1u << greater_count) - 1),
+                             _mm512_maskz_compress_epi32(greater, v));
+    *left += 16 - greater_count;
+    *right -= greater_count;
+}
+
+// As partition_avx2(), 16 lanes at a time, for n >= 32
+__attribute__((target("avx512f,popcnt")))
+static int partition_avx512(int* values, int n, int pivot) {
+    __m512i pivots = _mm512_set1_epi32(pivot);
+    __m512i first = _mm512_loadu_si512(values);
+    __m512i last = _mm512_loadu_si512(values + n - 16);
+    int read_left = 16, read_right = n - 16;
+    int write_left = 0, write_right = n;
+    while (read_right - read_left >= 16) {
+        __m512i v;
+        if (read_left - write_left <= write_right - read_right) {
+            v = _mm512_loadu_si512(values + read_left);
+            read_left += 16;
+        } else {
+            read_right -= 16;
+            v = _mm512_loadu_si512(values + read_right);
+        }
+        partition_store_avx512(values, v, pivots, &write_left, &write_right);
+    }
+    int rest[16];
+    int rest_count = read_right - read_left;
+    memcpy(rest, values + read_left, (size_t)rest_count * sizeof(int));
+    for (int i = 0; i < rest_count; i++) {
+        if (rest[i] <= pivot) {
+            values[write_left++] = rest[i];
+        } else {
+            values[--write_right] = rest[i];
+        }
+    }
+    partition_store_avx512(values, first, pivots, &write_left, &write_right);
+    partition_store_avx512(values, last, pivots, &write_left, &write_right);
+    return write_left;
+}
+
+static const SimdSorter SIMD_SORTER_AVX512 = {32, sort_small_avx512, partition_avx512};
+#endif
+
+// Sort backends, in order of preference; sort_ints() takes the first the CPU has
+#define SORT_BACKEND_QSORT  0
+#define SORT_BACKEND_AVX2   1
+#define SORT_BACKEND_AVX512 2
+
+static int sort_backend_supported(int backend) {
+#if defined(__x86_64__) && defined(__GNUC__)
+    switch (backend) {
+    case SORT_BACKEND_AVX2: return __builtin_cpu_supports("avx2");
+    case SORT_BACKEND_AVX512: return __builtin_cpu_supports("avx512f");
+    }
+#endif
+    return backend == SORT_BACKEND_QSORT;
+}
+
+static void sort_ints_with(int backend, int* values, int n) {
+#if defined(__x86_64__) && defined(__GNUC__)
+    const SimdSorter* sorter = backend == SORT_BACKEND_AVX512 ? &SIMD_SORTER_AVX512
+                             : backend == SORT_BACKEND_AVX2 ? &SIMD_SORTER_AVX2 : NULL;
+    if (sorter != NULL) {
+        int depth = 0;
+        for (int size = n; size > 1; size /= 2) {
+            depth += 2;
+        }
+        simd_quicksort(sorter, values, n, depth);
+        return;
+    }
+#endif
+    (void)backend;
+    qsort(values, n, sizeof(int), compare_ints);
+}
+
+static int widest_sort_backend(void) {
+    return sort_backend_supported(SORT_BACKEND_AVX512) ? SORT_BACKEND_AVX512
+         : sort_backend_supported(SORT_BACKEND_AVX2) ? SORT_BACKEND_AVX2 : SORT_BACKEND_QSORT;
+}
+
+// Sort ints ascending with the tuned backend, else the widest the CPU runs
+static void sort_ints(int* values, int n) {
+    sort_ints_with(tuning.sort_backend >= 0 ? tuning.sort_backend : widest_sort_backend(), values, n);
 }
 
-// Create and initialize a new calculator
-StatisticsCalculator* create_calculator(void) {
-    StatisticsCalculator* calc = (StatisticsCalculator*)malloc(sizeof(StatisticsCalculator));
-    if (calc == NULL) {
-        printf("Memory allocation failed\n");
-        return NULL;
+// Autotuning: time the candidate kernels on this host and keep the crossovers
+#define TUNING_VALUES (1 << 18)   // Values per calibration sort, past the L2 cache
+#define TUNING_SMALL_SORTS 16384  // Arrays per network calibration
+#define TUNING_KERNEL_NETWORK  (-1)
+#define TUNING_KERNEL_COUNTING (-2)
+#define TUNING_KERNEL_MERGE    (-3)
+
+static const char* const SORT_BACKEND_NAMES[] = {"qsort", "avx2", "avx512"};
+
+static double tuning_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Best of five timings of sorting `reps` consecutive arrays of n values from
+// input into output with a sort backend or one of the TUNING_KERNEL_*
+static double time_sort_kernel(int kernel, const int* input, int* output, int n, int reps) {
+    double best = 0.0;
+    for (int round = 0; round < 5; round++) {
+        double start = tuning_seconds();
+        for (int r = 0; r < reps; r++) {
+            const int* values = input + (size_t)r * n;
+            int* sorted = output + (size_t)r * n;
+            if (kernel == TUNING_KERNEL_COUNTING) {
+                int min = values[0], max = values[0];
+                for (int i = 1; i < n; i++) {
+                    min = values[i] < min ? values[i] : min;
+                    max = values[i] > max ? values[i] : max;
+                }
+                counting_sort(sorted, values, n, min, max);
+            } else if (kernel == TUNING_KERNEL_MERGE) {
+                merge_runs(sorted, values, n, count_runs(values, n, n));
+            } else {
+                memcpy(sorted, values, (size_t)n * sizeof(int));
+                if (kernel == TUNING_KERNEL_NETWORK) {
+                    network_sort(sorted, n);
+                } else {
+                    sort_ints_with(kernel, sorted, n);
+                }
+            }
+        }
+        double elapsed = tuning_seconds() - start;
+        best = round == 0 || elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+// Measure every threshold on this host; -1 if the buffers cannot be allocated
+static int calibrate_thresholds(TuningThresholds* result) {
+    size_t size = TUNING_VALUES > TUNING_SMALL_SORTS * SMALL_NETWORK_MAX ? TUNING_VALUES
+                                                                         : TUNING_SMALL_SORTS * SMALL_NETWORK_MAX;
+    int* input = (int*)malloc(size * sizeof(int));
+    int* output = (int*)malloc(size * sizeof(int));
+    if (input == NULL || output == NULL) {
+        printf("Memory allocation failed\n");
+        free(input);
+        free(output);
+        return -1;
+    }
+    unsigned seed = 1;
+    int n = TUNING_VALUES;
+
+    // Fastest comparison sort on wide random data
+    for (int i = 0; i < n; i++) {
+        input[i] = (int)((unsigned)rand_r(&seed) * 2654435761u);
+    }
+    int backend = SORT_BACKEND_QSORT;
+    double backend_time = time_sort_kernel(backend, input, output, n, 1);
+    for (int candidate = SORT_BACKEND_AVX2; candidate <= SORT_BACKEND_AVX512; candidate++) {
+        double elapsed = sort_backend_supported(candidate) ? time_sort_kernel(candidate, input, output, n, 1) : 0.0;
+        if (elapsed > 0.0 && elapsed < backend_time) {
+            backend = candidate;
+            backend_time = elapsed;
+        }
+    }
+    result->sort_backend = backend;
+
+    // Widest value range, relative to n, where counting still wins
+    result->counting_sort_percent = 0;
+    for (int percent = 25; percent <= 3200; percent *= 2) {
+        int span = (int)((long long)n * percent / 100);
+        for (int i = 0; i < n; i++) {
+            input[i] = (int)((unsigned)rand_r(&seed) % (unsigned)span);
+        }
+        if (time_sort_kernel(TUNING_KERNEL_COUNTING, input, output, n, 1) >=
+            time_sort_kernel(backend, input, output, n, 1)) {
+            break;
+        }
+        result->counting_sort_percent = percent;
+    }
+
+    // Most existing runs for which merging them beats sorting afresh
+    result->run_merge_max_runs = 1;
+    for (int runs = 2; runs <= 4096; runs *= 2) {
+        for (int i = 0; i < n; i++) {
+            input[i] = (int)((unsigned)rand_r(&seed) * 2654435761u);
+        }
+        for (int r = 0; r < runs; r++) {
+            int start = (int)((long long)n * r / runs);
+            sort_ints_with(backend, input + start, (int)((long long)n * (r + 1) / runs) - start);
+        }
+        if (time_sort_kernel(TUNING_KERNEL_MERGE, input, output, n, 1) >=
+            time_sort_kernel(backend, input, output, n, 1)) {
+            break;
+        }
+        result->run_merge_max_runs = runs;
+    }
+
+    // Largest size for which the network beats the backend on many small arrays.
+    // These timings are short, so one noisy loss must not end the search early.
+    result->small_network_max = 1;
+    for (int i = 0; i < TUNING_SMALL_SORTS * SMALL_NETWORK_MAX; i++) {
+        input[i] = (int)((unsigned)rand_r(&seed) * 2654435761u);
+    }
+    for (int small = 2; small <= SMALL_NETWORK_MAX; small++) {
+        if (time_sort_kernel(TUNING_KERNEL_NETWORK, input, output, small, TUNING_SMALL_SORTS) <
+            time_sort_kernel(backend, input, output, small, TUNING_SMALL_SORTS)) {
+            result->small_network_max = small;
+        }
+    }
+    free(input);
+    free(output);
+    return 0;
+}
+
+// The CPU model from /proc/cpuinfo, so a tuning file moved between hosts is redone
+static void read_cpu_model(char* model, size_t size) {
+    snprintf(model, size, "unknown");
+    FILE* file = fopen("/proc/cpuinfo", "r");
+    if (file == NULL) {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char* colon = strchr(line, ':');
+        if (strncmp(line, "model name", 10) == 0 && colon != NULL) {
+            colon += strspn(colon + 1, " \t") + 1;
+            colon[strcspn(colon, "\n")] = '\0';
+            snprintf(model, size, "%s", colon);
+            break;
+        }
+    }
+    fclose(file);
+}
+
+// Read thresholds saved for `cpu`; -1 when missing, for another CPU or invalid
+static int load_thresholds(const char* path, const char* cpu, TuningThresholds* result) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    TuningThresholds loaded = {-2, -1, -1, -1};
+    int same_cpu = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char name[32], text[224];
+        line[strcspn(line, "\n")] = '\0';
+        if (line[0] == '#' || sscanf(line, "%31s %223[^\n]", name, text) != 2) {
+            continue;
+        }
+        if (strcmp(name, "cpu") == 0) {
+            same_cpu = strcmp(text, cpu) == 0;
+        } else if (strcmp(name, "sort_backend") == 0) {
+            for (int b = SORT_BACKEND_QSORT; b <= SORT_BACKEND_AVX512; b++) {
+                if (strcmp(text, SORT_BACKEND_NAMES[b]) == 0 && sort_backend_supported(b)) {
+                    loaded.sort_backend = b;
+                }
+            }
+        } else if (strcmp(name, "counting_sort_percent") == 0) {
+            loaded.counting_sort_percent = atoi(text);
+        } else if (strcmp(name, "run_merge_max_runs") == 0) {
+            loaded.run_merge_max_runs = atoi(text);
+        } else if (strcmp(name, "small_network_max") == 0) {
+            loaded.small_network_max = atoi(text);
+        }
+    }
+    fclose(file);
+    if (!same_cpu || loaded.sort_backend < 0 || loaded.counting_sort_percent < 0 ||
+        loaded.run_merge_max_runs < 1 || loaded.small_network_max < 1 ||
+        loaded.small_network_max > SMALL_NETWORK_MAX) {
+        return -1;
+    }
+    *result = loaded;
+    return 0;
+}
+
+// Write the thresholds to `path`, creating its directory (e.g. a fresh
+// ~/.cache) if needed; -1 without a message when that fails
+static int save_thresholds(const char* path, const char* cpu, const TuningThresholds* thresholds) {
+    const char* slash = strrchr(path, '/');
+    char directory[4096];
+    if (slash != NULL && slash != path && (size_t)(slash - path) < sizeof(directory)) {
+        memcpy(directory, path, (size_t)(slash - path));
+        directory[slash - path] = '\0';
+        if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+            return -1;
+        }
+    }
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        return -1;
+    }
+    fprintf(file, "# StatisticsCalculator dispatch thresholds, measured by tune_thresholds()\n");
+    fprintf(file, "cpu %s\n", cpu);
+    fprintf(file, "sort_backend %s\n", SORT_BACKEND_NAMES[thresholds->sort_backend]);
+    fprintf(file, "counting_sort_percent %d\n", thresholds->counting_sort_percent);
+    fprintf(file, "run_merge_max_runs %d\n", thresholds->run_merge_max_runs);
+    fprintf(file, "small_network_max %d\n", thresholds->small_network_max);
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+// Apply the thresholds saved in `path` for this CPU, or measure them (well
+// under a second) and save them there; `force` always measures. A NULL path
+// means $STATS_TUNING_FILE, else ~/.cache/statscalc-tuning. Call it once at
+// startup, before other threads use the engine. Returns 0 when loaded, 1 when
+// measured and saved, 2 when measured but the file could not be written (the
+// thresholds still apply; the next start measures again), or -1 when
+// measuring failed.
+int tune_thresholds(const char* path, int force) {
+    char default_path[4096];
+    if (path == NULL) {
+        const char* home = getenv("HOME");
+        path = getenv("STATS_TUNING_FILE");
+        if (path == NULL) {
+            snprintf(default_path, sizeof(default_path), "%s/.cache/statscalc-tuning", home != NULL ? home : ".");
+            path = default_path;
+        }
+    }
+    char cpu[192];
+    read_cpu_model(cpu, sizeof(cpu));
+    TuningThresholds measured;
+    if (!force && load_thresholds(path, cpu, &measured) == 0) {
+        tuning = measured;
+        return 0;
+    }
+    if (calibrate_thresholds(&measured) != 0) {
+        return -1;
+    }
+    tuning = measured;
+    return save_thresholds(path, cpu, &measured) == 0 ? 1 : 2;
+}
+
+// Compute one statistic whose inputs are already cached
+static void compute_statistic(StatisticsCalculator* calc, int flag) {
+    const int* data = calc->data;
+    int n = calc->count;
+    switch (flag) {
+    case CACHE_SORTED: {
+        // Data that arrived in order is used as is, without a copy
+        int runs = count_runs(data, n, tuning.run_merge_max_runs);
+        if (runs == 1 && data[0] <= data[n - 1]) {
+            if (!sorted_shares_data(calc)) {
+                free(calc->sorted_data);
+            }
+            calc->sorted_data = calc->data;
+            calc->sorted_count = n;
+            break;
+        }
+        int* sorted = (int*)realloc(sorted_shares_data(calc) ? NULL : calc->sorted_data, (size_t)n * sizeof(int));
+        if (sorted == NULL) {
+            printf("Memory allocation failed\n");
+            return;
+        }
+        calc->sorted_data = sorted;
+        // Narrow ranges sort by counting: the histogram already holds the counts,
+        // and otherwise the running min/max say whether the bins stay small
+        if (n <= tuning.small_network_max) {
+            memcpy(sorted, data, (size_t)n * sizeof(int));
+            network_sort(sorted, n);
+        } else if (calc->cache_flags & CACHE_HISTOGRAM) {
+            expand_counts(sorted, calc->histogram, calc->histogram_base, calc->histogram_span);
+        } else {
+            if ((calc->cache_flags & (CACHE_MIN | CACHE_MAX)) != (CACHE_MIN | CACHE_MAX)) {
+                compute_statistic(calc, CACHE_MIN);
+            }
+            // Failing that, a few existing runs are merged rather than re-sorted
+            if ((!counting_sort_fits(calc->cache_min, calc->cache_max, n) ||
+                 counting_sort(sorted, data, n, calc->cache_min, calc->cache_max) != 0) &&
+                (runs > tuning.run_merge_max_runs || merge_runs(sorted, data, n, runs) != 0)) {
+                memcpy(sorted, data, (size_t)n * sizeof(int));
+                sort_ints(sorted, n);
+            }
+        }
+        calc->sorted_count = n;
+        break;
+    }
+    case CACHE_SUM: {
+        long long sum = 0;
+        for (int i = 0; i < n; i++) {
+            sum += data[i];
+        }
+        calc->cache_sum = sum;
+        break;
+    }
+    case CACHE_MIN:
+    case CACHE_MAX:
+        // Both ends come from the same pass, or straight from the sorted data
+        if (calc->cache_flags & CACHE_SORTED) {
+            calc->cache_min = calc->sorted_data[0];
+            calc->cache_max = calc->sorted_data[n - 1];
+        } else {
+            int min = data[0], max = data[0];
+            for (int i = 1; i < n; i++) {
+                min = data[i] < min ? data[i] : min;
+                max = data[i] > max ? data[i] : max;
+            }
+            calc->cache_min = min;
+            calc->cache_max = max;
+        }
+        flag = CACHE_MIN | CACHE_MAX;
+        break;
+    case CACHE_MEAN:
+        calc->cache_mean = (float)((double)calc->cache_sum / n);
+        break;
+    case CACHE_STD_DEV_SAMPLE:
+    case CACHE_STD_DEV_POPULATION: {
+        // Both deviations share the squared differences from the mean, taken
+        // in double: cache_mean is rounded to float, which is off by units
+        // for values near INT_MAX
+        double mean = (double)calc->cache_sum / n;
+        double squares = 0.0;  // A float accumulator drifts visibly past ~1e4 values
+        for (int i = 0; i < n; i++) {
+            double diff = data[i] - mean;
+            squares += diff * diff;
+        }
+        calc->cache_std_dev_population = (float)sqrt(squares / n);
+        flag = CACHE_STD_DEV_POPULATION;
+        if (n >= 2) {
+            calc->cache_std_dev_sample = (float)sqrt(squares / (n - 1));
+            flag |= CACHE_STD_DEV_SAMPLE;
+        }
+        break;
+    }
+    case CACHE_MEDIAN: {
+        // Middle value, or the average of the two middle values; summed in 64 bits.
+        // Small unsorted data goes through a median network instead of the histogram.
+        int middle, next;
+        if (n <= tuning.small_network_max && !(calc->cache_flags & CACHE_SORTED)) {
+            network_median(data, n, &middle, &next);
+        } else {
+            values_at_rank(calc, (n - 1) / 2, &middle, &next);
+        }
+        calc->cache_median = (float)(((long long)middle + (n % 2 ? middle : next)) / 2.0);
+        break;
+    }
+    case CACHE_MODE:
+        if ((calc->cache_flags & CACHE_SORTED ? scan_modes(calc) : histogram_modes(calc)) != 0) {
+            return;
+        }
+        break;
+    case CACHE_RANGE:
+        calc->cache_range = calc->cache_max - calc->cache_min;
+        break;
+    }
+    calc->cache_flags |= flag;
+}
+
+// Make the statistics in `flags` valid, computing each missing one and its
+// missing inputs exactly once. Returns 0 on success, or -1 when the data is
+// empty or an allocation failed.
+int require_statistics(StatisticsCalculator* calc, int flags) {
+    int missing = flags & ~calc->cache_flags;
+    if (missing == 0) {
+        return 0;
+    }
+    if (calc->count == 0) {
+        return -1;
+    }
+    for (int i = CACHE_GRAPH_SIZE - 1; i >= 0; i--) {
+        if (missing & CACHE_GRAPH[i].flag) {
+            int alternative = CACHE_GRAPH[i].alternative;
+            int inputs = alternative && (calc->cache_flags & alternative) == alternative ? alternative
+                                                                                       : CACHE_GRAPH[i].inputs;
+            if (CACHE_GRAPH[i].flag == CACHE_MEDIAN && calc->count <= tuning.small_network_max) {
+                inputs = CACHE_VALUES;  // A median network reads the values directly
+            }
+            missing |= inputs & ~CACHE_VALUES & ~calc->cache_flags;
+        }
+    }
+    for (int i = 0; i < CACHE_GRAPH_SIZE; i++) {
+        if ((missing & CACHE_GRAPH[i].flag) && !(calc->cache_flags & CACHE_GRAPH[i].flag)) {
+            compute_statistic(calc, CACHE_GRAPH[i].flag);
+        }
+    }
+    return (calc->cache_flags & flags) == flags ? 0 : -1;
+}
+
+// Make values_at_rank() usable: the sorted data, or the histogram while it lasts
+static int require_order(StatisticsCalculator* calc) {
+    return calc->cache_flags & (CACHE_SORTED | CACHE_HISTOGRAM) ? 0 : require_statistics(calc, CACHE_SORTED);
+}
+
+// Add a single value
+void add_value(StatisticsCalculator* calc, int value) {
+    if (calc->count == calc->capacity && reserve_capacity(calc, calc->count + 1) != 0) {
+        return;
+    }
+    calc->data[calc->count++] = value;
+    cache_append(calc, &value, 1);
+}
+
+// Add multiple values
+void add_values(StatisticsCalculator* calc, const int values[], int count) {
+    if (count <= 0) {
+        return;
+    }
+    if (count > INT_MAX - calc->count) {
+        printf("Error: Data size limit (%d) exceeded\n", INT_MAX);
+        return;
+    }
+    if (reserve_capacity(calc, calc->count + count) != 0) {
+        return;
+    }
+    memcpy(calc->data + calc->count, values, (size_t)count * sizeof(int));
+    calc->count += count;
+    cache_append(calc, values, count);
+}
+
+// Clear all data and cache, keeping the allocated buffers for reuse
+void clear_data(StatisticsCalculator* calc) {
+    calc->count = 0;
+    calc->sorted_count = 0;
+    calc->cache_mode_count = 0;
+    calc->cache_flags = 0;
+    calc->version++;
+}
+
+// Sort data for median and range calculations
+void sort_data(StatisticsCalculator* calc) {
+    require_statistics(calc, CACHE_SORTED);
+}
+
+// Calculate the exact sum of the data
+long long calculate_sum(StatisticsCalculator* calc) {
+    if (calc->count == 0) {
+        return 0;
+    }
+    require_statistics(calc, CACHE_SUM);
+    return calc->cache_sum;
+}
+
+// Calculate mean
+float calculate_mean(StatisticsCalculator* calc) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate mean - data is empty\n");
+        return 0.0f;
+    }
+
+    require_statistics(calc, CACHE_MEAN);
+    return calc->cache_mean;
+}
+
+// Calculate median
+float calculate_median(StatisticsCalculator* calc) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate median - data is empty\n");
+        return 0.0f;
+    }
+
+    if (require_statistics(calc, CACHE_MEDIAN) != 0) {
+        return 0.0f;
+    }
+    return calc->cache_median;
+}
+
+// Calculate a percentile (0-100), interpolating linearly between neighbours
+float calculate_percentile(StatisticsCalculator* calc, float percentile) {
+    return (float)calculate_percentile_double(calc, percentile);
+}
+
+// Median as a double, exact for any int data (float rounds beyond 2^24)
+double calculate_median_double(StatisticsCalculator* calc) {
+    long long twice_median;
+    if (calculate_median_exact(calc, &twice_median) != 0) {
+        return 0.0;
+    }
+    return (double)twice_median / 2.0;  // |twice_median| < 2^33, so this is exact
+}
+
+// Percentile (0-100) as a double, interpolating linearly between neighbours
+double calculate_percentile_double(StatisticsCalculator* calc, double percentile) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate percentile - data is empty\n");
+        return 0.0;
+    }
+    if (!(percentile >= 0.0 && percentile <= 100.0)) {
+        printf("Error: Percentile must be between 0 and 100\n");
+        return 0.0;
+    }
+
+    if (require_order(calc) != 0) {
+        return 0.0;
+    }
+    double rank = percentile / 100.0 * (calc->count - 1);
+    int lower = (int)rank;
+    lower = lower < calc->count - 1 ? lower : calc->count - 1;
+    int value, next;
+    values_at_rank(calc, lower, &value, &next);
+    return value + (rank - lower) * ((double)next - value);
+}
+
+// Exact median as a rational: the median is *twice_median / 2.
+// Returns 0, or -1 if the data is empty.
+int calculate_median_exact(StatisticsCalculator* calc, long long* twice_median) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate median - data is empty\n");
+        return -1;
+    }
+    int n = calc->count;
+    int middle, next;
+    if (n <= tuning.small_network_max && !(calc->cache_flags & CACHE_SORTED)) {
+        network_median(calc->data, n, &middle, &next);
+    } else if (require_order(calc) != 0) {
+        return -1;
+    } else {
+        values_at_rank(calc, (n - 1) / 2, &middle, &next);
+    }
+    *twice_median = (long long)middle + (n % 2 ? middle : next);
+    return 0;
+}
+
+// Calculators waiting for a full group of lanes, per size
+typedef struct {
+    void (*run)(StatisticsCalculator* const group[], int n, double medians[]);
+    StatisticsCalculator* members[SMALL_NETWORK_MAX + 1][NETWORK_LANES];
+    int indices[SMALL_NETWORK_MAX + 1][NETWORK_LANES];
+    int filled[SMALL_NETWORK_MAX + 1];
+    double* medians;
+    int computed;
+} MedianGroups;
+
+// Run the waiting calculators of size n, padding the lanes with the last one
+static void run_median_group(MedianGroups* groups, int n) {
+    int filled = groups->filled[n];
+    if (filled == 0) {
+        return;
+    }
+    for (int lane = filled; lane < NETWORK_LANES; lane++) {
+        groups->members[n][lane] = groups->members[n][filled - 1];
+    }
+    double results[NETWORK_LANES];
+    groups->run(groups->members[n], n, results);
+    for (int lane = 0; lane < filled; lane++) {
+        groups->medians[groups->indices[n][lane]] = results[lane];
+    }
+    groups->computed += filled;
+    groups->filled[n] = 0;
+}
+
+// Medians of many small calculators at once. Calculators holding the same
+// number of values, up to SMALL_NETWORK_MAX, are grouped 8 at a time and run
+// through one median network across vector lanes; a partial group repeats its
+// last member. medians[i] is exact like calculate_median_double(), or NaN when
+// calcs[i] is empty or larger. Nothing is cached. Returns how many were computed.
+int calculate_small_medians(StatisticsCalculator* const calcs[], int count, double medians[]) {
+    MedianGroups groups = {lane_medians_generic, {{NULL}}, {{0}}, {0}, medians, 0};
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) {
+        groups.run = lane_medians_avx2;
+    }
+#endif
+    for (int i = 0; i < count; i++) {
+        int n = calcs[i]->count;
+        if (n < 1 || n > SMALL_NETWORK_MAX) {
+            medians[i] = NAN;
+            continue;
+        }
+        groups.members[n][groups.filled[n]] = calcs[i];
+        groups.indices[n][groups.filled[n]++] = i;
+        if (groups.filled[n] == NETWORK_LANES) {
+            run_median_group(&groups, n);
+        }
+    }
+    for (int n = 1; n <= SMALL_NETWORK_MAX; n++) {
+        run_median_group(&groups, n);
+    }
+    return groups.computed;
+}
+
+// Exact percentile (0-100) as *twice_value / 2, interpolating by midpoint: a
+// rank between two neighbours yields their average, as numpy's "midpoint"
+int calculate_percentile_exact(StatisticsCalculator* calc, double percentile, long long* twice_value) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate percentile - data is empty\n");
+        return -1;
+    }
+    if (!(percentile >= 0.0 && percentile <= 100.0)) {
+        printf("Error: Percentile must be between 0 and 100\n");
+        return -1;
+    }
+    if (require_order(calc) != 0) {
+        return -1;
+    }
+    double rank = percentile / 100.0 * (calc->count - 1);
+    int lower = (int)rank;
+    int value, next;
+    values_at_rank(calc, lower, &value, &next);
+    *twice_value = (long long)value + (rank > lower ? next : value);
+    return 0;
+}
+
+static int compare_int64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// The k-th smallest of `count` int64 values (k from 0). Reorders `values` so
+// that everything before k is <= the result and everything after is >=.
+// Quickselect in expected O(n); a run of poor pivots falls back to sorting.
+int64_t select_int64(int64_t values[], size_t count, size_t k) {
+    ptrdiff_t low = 0, high = (ptrdiff_t)count - 1, target = (ptrdiff_t)k;
+    int budget = 2;
+    for (size_t n = count; n > 1; n >>= 1) {
+        budget += 2;
+    }
+    while (high > low) {
+        if (budget-- == 0) {
+            qsort(values + low, (size_t)(high - low + 1), sizeof(int64_t), compare_int64);
+            break;
+        }
+        // Median of three as the pivot
+        ptrdiff_t middle = low + (high - low) / 2;
+        int64_t a = values[low], b = values[middle], c = values[high];
+        int64_t pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+        ptrdiff_t i = low, j = high;
+        while (i <= j) {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j) {
+                int64_t swap = values[i];
+                values[i++] = values[j];
+                values[j--] = swap;
+            }
+        }
+        if (target <= j) {
+            high = j;
+        } else if (target >= i) {
+            low = i;
+        } else {
+            break;  // values[j+1 .. i-1] all equal the pivot
+        }
+    }
+    return values[k];
+}
+
+// Exact median of int64 values as its two middle order statistics (equal for
+// an odd count); the sum may not fit in 64 bits, so it is left to the caller.
+// Reorders `values`. Returns 0, or -1 if there are none.
+int median_int64(int64_t values[], size_t count, int64_t* lower, int64_t* upper) {
+    if (count == 0) {
+        printf("Error: Cannot calculate median - data is empty\n");
+        return -1;
+    }
+    *upper = select_int64(values, count, count / 2);
+    *lower = *upper;
+    if (count % 2 == 0) {
+        // Everything below count/2 is <= upper after selection; the lower middle is their max
+        *lower = values[0];
+        for (size_t i = 1; i < count / 2; i++) {
+            *lower = values[i] > *lower ? values[i] : *lower;
+        }
+    }
+    return 0;
+}
+
+// Percentile (0-100) of int64 values, interpolating linearly; reorders `values`
+double percentile_int64(int64_t values[], size_t count, double percentile) {
+    if (count == 0) {
+        printf("Error: Cannot calculate percentile - data is empty\n");
+        return 0.0;
+    }
+    if (!(percentile >= 0.0 && percentile <= 100.0)) {
+        printf("Error: Percentile must be between 0 and 100\n");
+        return 0.0;
+    }
+    double rank = percentile / 100.0 * (double)(count - 1);
+    size_t lower = (size_t)rank;
+    if (lower >= count - 1) {
+        lower = count - 1;
+    }
+    int64_t value = select_int64(values, count, lower);
+    double fraction = rank - (double)lower;
+    if (fraction <= 0.0 || lower == count - 1) {
+        return (double)value;
+    }
+    int64_t next = values[lower + 1];
+    for (size_t i = lower + 2; i < count; i++) {
+        next = values[i] < next ? values[i] : next;
+    }
+    // The unsigned difference is exact even when it exceeds INT64_MAX
+    return (double)((long double)value + (long double)fraction * (long double)((uint64_t)next - (uint64_t)value));
+}
+
+// Calculate mode
+void calculate_mode(StatisticsCalculator* calc, int modes[], int* mode_count) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate mode - data is empty\n");
+        *mode_count = 0;
+        return;
+    }
+
+    if (require_statistics(calc, CACHE_MODE) != 0) {
+        *mode_count = 0;
+        return;
+    }
+    memcpy(modes, calc->cache_mode, (size_t)calc->cache_mode_count * sizeof(int));
+    *mode_count = calc->cache_mode_count;
+}
+
+// Top-k selection keeps the k best (value, count) pairs in a min-heap whose
+// root is the worst kept entry. Better means a higher count, then a smaller
+// value, so results are deterministic under ties.
+typedef struct {
+    int value;
+    long long count;
+} TopKEntry;
+
+static int topk_better(const TopKEntry* a, const TopKEntry* b) {
+    return a->count > b->count || (a->count == b->count && a->value < b->value);
+}
+
+static void topk_sift_down(TopKEntry heap[], int size, int i) {
+    TopKEntry entry = heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && topk_better(&heap[child], &heap[child + 1])) {
+            child++;
+        }
+        if (!topk_better(&entry, &heap[child])) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = entry;
+}
+
+// Offer one candidate: O(1) when it does not beat the worst kept, else O(log k)
+static void topk_offer(TopKEntry heap[], int* size, int k, int value, long long count) {
+    TopKEntry entry = {value, count};
+    if (*size < k) {
+        int i = (*size)++;
+        while (i > 0 && topk_better(&heap[(i - 1) / 2], &entry)) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = entry;
+    } else if (topk_better(&entry, &heap[0])) {
+        heap[0] = entry;
+        topk_sift_down(heap, *size, 0);
+    }
+}
+
+static int compare_topk(const void* a, const void* b) {
+    return topk_better((const TopKEntry*)b, (const TopKEntry*)a) - topk_better((const TopKEntry*)a, (const TopKEntry*)b);
+}
+
+static unsigned topk_hash(int value, int shift) {
+    return ((unsigned)value * 0x9E3779B1u) >> shift;  // Fibonacci hashing
+}
+
+// Offer every distinct value with its count: from the histogram or the runs of
+// the sorted data when cached, else from an open-addressing hash counter
+static int topk_collect(StatisticsCalculator* calc, TopKEntry heap[], int* size, int k) {
+    const int* data = calc->data;
+    int n = calc->count;
+    if (calc->cache_flags & CACHE_HISTOGRAM) {
+        for (int i = 0; i < calc->histogram_span; i++) {
+            if (calc->histogram[i] != 0) {
+                topk_offer(heap, size, k, calc->histogram_base + i, calc->histogram[i]);
+            }
+        }
+        return 0;
+    }
+    if (calc->cache_flags & CACHE_SORTED) {
+        const int* sorted = calc->sorted_data;
+        int run_start = 0;
+        for (int i = 1; i <= n; i++) {
+            if (i == n || sorted[i] != sorted[i - 1]) {
+                topk_offer(heap, size, k, sorted[i - 1], i - run_start);
+                run_start = i;
+            }
+        }
+        return 0;
+    }
+
+    int bits = 10;
+    int* keys = NULL;
+    int* counts = NULL;
+    int used = 0;
+    for (int i = 0; i < n; i++) {
+        if (keys == NULL || used * 2 >= (1 << bits)) {
+            // (Re)build at twice the size; a zero count marks an empty slot
+            int grown_bits = keys == NULL ? bits : bits + 1;
+            int* grown_keys = (int*)malloc(((size_t)1 << grown_bits) * sizeof(int));
+            int* grown_counts = (int*)calloc((size_t)1 << grown_bits, sizeof(int));
+            if (grown_keys == NULL || grown_counts == NULL) {
+                printf("Memory allocation failed\n");
+                free(grown_keys);
+                free(grown_counts);
+                free(keys);
+                free(counts);
+                return -1;
+            }
+            unsigned grown_mask = (1u << grown_bits) - 1;
+            for (int slot = 0; keys != NULL && slot < (1 << bits); slot++) {
+                if (counts[slot] != 0) {
+                    unsigned at = topk_hash(keys[slot], 32 - grown_bits);
+                    while (grown_counts[at] != 0) {
+                        at = (at + 1) & grown_mask;
+                    }
+                    grown_keys[at] = keys[slot];
+                    grown_counts[at] = counts[slot];
+                }
+            }
+            free(keys);
+            free(counts);
+            keys = grown_keys;
+            counts = grown_counts;
+            bits = grown_bits;
+        }
+        unsigned mask = (1u << bits) - 1;
+        unsigned at = topk_hash(data[i], 32 - bits);
+        while (counts[at] != 0 && keys[at] != data[i]) {
+            at = (at + 1) & mask;
+        }
+        if (counts[at] == 0) {
+            keys[at] = data[i];
+            used++;
+        }
+        counts[at]++;
+    }
+    for (int slot = 0; slot < (1 << bits); slot++) {
+        if (counts[slot] != 0) {
+            topk_offer(heap, size, k, keys[slot], counts[slot]);
+        }
+    }
+    free(keys);
+    free(counts);
+    return 0;
+}
+
+// The k most frequent values, most frequent first (ties by smaller value), in
+// O(n + d log k) for d distinct values. Returns how many were written, which
+// is less than k when there are fewer distinct values; -1 on failure.
+int calculate_top_k(StatisticsCalculator* calc, int k, int values[], int counts[]) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate top-k - data is empty\n");
+        return 0;
+    }
+    if (k <= 0) {
+        return 0;
+    }
+    k = k < calc->count ? k : calc->count;
+    TopKEntry* heap = (TopKEntry*)malloc((size_t)k * sizeof(TopKEntry));
+    if (heap == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    int size = 0;
+    if (topk_collect(calc, heap, &size, k) != 0) {
+        free(heap);
+        return -1;
+    }
+    qsort(heap, (size_t)size, sizeof(TopKEntry), compare_topk);
+    for (int i = 0; i < size; i++) {
+        values[i] = heap[i].value;
+        counts[i] = (int)heap[i].count;
+    }
+    free(heap);
+    return size;
+}
+
+// Space-Saving sketch (Metwally et al.) for heavy hitters in a stream, in
+// O(capacity) memory. Every value with a true frequency above
+// total / capacity is monitored. A reported count overestimates the truth
+// by at most the slot's error, which is itself at most total / capacity.
+typedef struct {
+    int capacity;
+    int size;
+    int* values;          // Monitored value per slot
+    long long* counts;    // Estimated count per slot
+    long long* errors;    // Overestimation bound per slot
+    int* heap;            // Slots as a min-heap by count
+    int* heap_index;      // Position of each slot in the heap
+    int* table;           // Open-addressing index: slot + 1, or 0 when empty
+    int table_bits;
+    long long total;
+} TopKSketch;
+
+TopKSketch* create_topk_sketch(int capacity);
+void sketch_add(TopKSketch* sketch, int value);
+void sketch_add_values(TopKSketch* sketch, const int values[], int count);
+int sketch_top_k(const TopKSketch* sketch, int k, int values[], long long counts[], long long errors[]);
+int sketch_mode(const TopKSketch* sketch, int* value, long long* count);
+void free_topk_sketch(TopKSketch* sketch);
+
+TopKSketch* create_topk_sketch(int capacity) {
+    if (capacity <= 0 || capacity > (1 << 28)) {
+        printf("Error: Sketch capacity must be between 1 and %d\n", 1 << 28);
+        return NULL;
+    }
+    TopKSketch* sketch = (TopKSketch*)calloc(1, sizeof(TopKSketch));
+    if (sketch == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    sketch->capacity = capacity;
+    sketch->table_bits = 1;
+    while ((1 << sketch->table_bits) < 2 * capacity) {
+        sketch->table_bits++;
+    }
+    sketch->values = (int*)malloc((size_t)capacity * sizeof(int));
+    sketch->counts = (long long*)malloc((size_t)capacity * sizeof(long long));
+    sketch->errors = (long long*)malloc((size_t)capacity * sizeof(long long));
+    sketch->heap = (int*)malloc((size_t)capacity * sizeof(int));
+    sketch->heap_index = (int*)malloc((size_t)capacity * sizeof(int));
+    sketch->table = (int*)calloc((size_t)1 << sketch->table_bits, sizeof(int));
+    if (sketch->values == NULL || sketch->counts == NULL || sketch->errors == NULL ||
+        sketch->heap == NULL || sketch->heap_index == NULL || sketch->table == NULL) {
+        printf("Memory allocation failed\n");
+        free_topk_sketch(sketch);
+        return NULL;
+    }
+    return sketch;
+}
+
+void free_topk_sketch(TopKSketch* sketch) {
+    if (sketch == NULL) {
+        return;
+    }
+    free(sketch->values);
+    free(sketch->counts);
+    free(sketch->errors);
+    free(sketch->heap);
+    free(sketch->heap_index);
+    free(sketch->table);
+    free(sketch);
+}
+
+static void sketch_heap_place(TopKSketch* sketch, int position, int slot) {
+    sketch->heap[position] = slot;
+    sketch->heap_index[slot] = position;
+}
+
+// Restore the heap after the count of the slot at `position` grew
+static void sketch_sift_down(TopKSketch* sketch, int position) {
+    int slot = sketch->heap[position];
+    for (;;) {
+        int child = 2 * position + 1;
+        if (child >= sketch->size) {
+            break;
+        }
+        if (child + 1 < sketch->size &&
+            sketch->counts[sketch->heap[child + 1]] < sketch->counts[sketch->heap[child]]) {
+            child++;
+        }
+        if (sketch->counts[sketch->heap[child]] >= sketch->counts[slot]) {
+            break;
+        }
+        sketch_heap_place(sketch, position, sketch->heap[child]);
+        position = child;
+    }
+    sketch_heap_place(sketch, position, slot);
+}
+
+// Table position of `value`, or of the empty slot where it would go
+static unsigned sketch_find(const TopKSketch* sketch, int value) {
+    unsigned mask = (1u << sketch->table_bits) - 1;
+    unsigned at = topk_hash(value, 32 - sketch->table_bits);
+    while (sketch->table[at] != 0 && sketch->values[sketch->table[at] - 1] != value) {
+        at = (at + 1) & mask;
+    }
+    return at;
+}
+
+// Remove the entry at `at`, shifting later probes back so lookups stay correct
+static void sketch_unlink(TopKSketch* sketch, unsigned at) {
+    unsigned mask = (1u << sketch->table_bits) - 1;
+    unsigned next = at;
+    for (;;) {
+        next = (next + 1) & mask;
+        if (sketch->table[next] == 0) {
+            break;
+        }
+        unsigned home = topk_hash(sketch->values[sketch->table[next] - 1], 32 - sketch->table_bits);
+        // Move the entry back unless its home lies cyclically in (at, next]
+        if (((next - home) & mask) >= ((next - at) & mask)) {
+            sketch->table[at] = sketch->table[next];
+            at = next;
+        }
+    }
+    sketch->table[at] = 0;
+}
+
+void sketch_add(TopKSketch* sketch, int value) {
+    sketch->total++;
+    unsigned at = sketch_find(sketch, value);
+    if (sketch->table[at] != 0) {
+        int slot = sketch->table[at] - 1;
+        sketch->counts[slot]++;
+        sketch_sift_down(sketch, sketch->heap_index[slot]);
+        return;
+    }
+    if (sketch->size < sketch->capacity) {
+        int slot = sketch->size++;
+        sketch->values[slot] = value;
+        sketch->counts[slot] = 1;
+        sketch->errors[slot] = 0;
+        // Count 1 is the minimum, so the new slot rises above every larger parent
+        int position = slot;
+        while (position > 0 && sketch->counts[sketch->heap[(position - 1) / 2]] > 1) {
+            sketch_heap_place(sketch, position, sketch->heap[(position - 1) / 2]);
+            position = (position - 1) / 2;
+        }
+        sketch_heap_place(sketch, position, slot);
+        sketch->table[at] = slot + 1;
+        return;
+    }
+    // Evict the least counted value; the newcomer inherits its count as error
+    int slot = sketch->heap[0];
+    sketch_unlink(sketch, sketch_find(sketch, sketch->values[slot]));
+    sketch->values[slot] = value;
+    sketch->errors[slot] = sketch->counts[slot];
+    sketch->counts[slot]++;
+    sketch->table[sketch_find(sketch, value)] = slot + 1;
+    sketch_sift_down(sketch, 0);
+}
+
+void sketch_add_values(TopKSketch* sketch, const int values[], int count) {
+    for (int i = 0; i < count; i++) {
+        sketch_add(sketch, values[i]);
+    }
+}
+
+// The k values with the highest estimated counts, best first. A value whose
+// count - error is at least the next one's count is guaranteed to be in the
+// true top k. Returns how many were written.
+int sketch_top_k(const TopKSketch* sketch, int k, int values[], long long counts[], long long errors[]) {
+    if (k <= 0 || sketch->size == 0) {
+        return 0;
+    }
+    k = k < sketch->size ? k : sketch->size;
+    TopKEntry* heap = (TopKEntry*)malloc((size_t)k * sizeof(TopKEntry));
+    if (heap == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    int size = 0;
+    for (int slot = 0; slot < sketch->size; slot++) {
+        topk_offer(heap, &size, k, sketch->values[slot], sketch->counts[slot]);
+    }
+    qsort(heap, (size_t)size, sizeof(TopKEntry), compare_topk);
+    for (int i = 0; i < size; i++) {
+        values[i] = heap[i].value;
+        counts[i] = heap[i].count;
+        if (errors != NULL) {
+            errors[i] = sketch->errors[sketch->table[sketch_find(sketch, heap[i].value)] - 1];
+        }
+    }
+    free(heap);
+    return size;
+}
+
+// Approximate mode of the stream: the value with the highest estimated count
+int sketch_mode(const TopKSketch* sketch, int* value, long long* count) {
+    return sketch_top_k(sketch, 1, value, count, NULL) == 1 ? 0 : -1;
+}
+
+// Calculate standard deviation
+float calculate_std_dev(StatisticsCalculator* calc, int population) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate standard deviation - data is empty\n");
+        return 0.0f;
+    }
+
+    if (!population && calc->count < 2) {
+        printf("Error: Need at least 2 data points for sample standard deviation\n");
+        return 0.0f;
+    }
+
+    require_statistics(calc, population ? CACHE_STD_DEV_POPULATION : CACHE_STD_DEV_SAMPLE);
+    return population ? calc->cache_std_dev_population : calc->cache_std_dev_sample;
+}
+
+// Calculate range
+int calculate_range(StatisticsCalculator* calc) {
+    if (calc->count == 0) {
+        printf("Error: Cannot calculate range - data is empty\n");
+        return 0;
+    }
+
+    require_statistics(calc, CACHE_RANGE);
+    return calc->cache_range;
+}
+
+// The data version: it starts at 1, grows with every add or clear and
+// survives checkpoints, so an unchanged version means unchanged data
+uint64_t calculator_version(const StatisticsCalculator* calc) {
+    return calc->version;
+}
+
+// Returns 0 if *known_version is current; otherwise updates it and returns 1.
+// Pass a known version of 0 to force a first evaluation.
+int calculator_changed(const StatisticsCalculator* calc, uint64_t* known_version) {
+    if (*known_version == calc->version) {
+        return 0;
+    }
+    *known_version = calc->version;
+    return 1;
+}
+
+// The *_if_changed variants return 0 without touching their result when the
+// data is still at *known_version, and otherwise compute it and return 1
+int calculate_mean_if_changed(StatisticsCalculator* calc, uint64_t* known_version, float* mean) {
+    if (!calculator_changed(calc, known_version)) {
+        return 0;
+    }
+    *mean = calculate_mean(calc);
+    return 1;
+}
+
+int calculate_median_if_changed(StatisticsCalculator* calc, uint64_t* known_version, float* median) {
+    if (!calculator_changed(calc, known_version)) {
+        return 0;
+    }
+    *median = calculate_median(calc);
+    return 1;
+}
+
+int calculate_percentile_if_changed(StatisticsCalculator* calc, float percentile, uint64_t* known_version,
+                                    float* value) {
+    if (!calculator_changed(calc, known_version)) {
+        return 0;
+    }
+    *value = calculate_percentile(calc, percentile);
+    return 1;
+}
+
+int calculate_mode_if_changed(StatisticsCalculator* calc, uint64_t* known_version, int modes[], int* mode_count) {
+    if (!calculator_changed(calc, known_version)) {
+        return 0;
+    }
+    calculate_mode(calc, modes, mode_count);
+    return 1;
+}
+
+int calculate_std_dev_if_changed(StatisticsCalculator* calc, int population, uint64_t* known_version,
+                                 float* std_dev) {
+    if (!calculator_changed(calc, known_version)) {
+        return 0;
+    }
+    *std_dev = calculate_std_dev(calc, population);
+    return 1;
+}
+
+int calculate_range_if_changed(StatisticsCalculator* calc, uint64_t* known_version, int* range) {
+    if (!calculator_changed(calc, known_version)) {
+        return 0;
+    }
+    *range = calculate_range(calc);
+    return 1;
+}
+
+// Print summary statistics
+void print_summary(StatisticsCalculator* calc) {
+    if (calc->count == 0) {
+        printf("StatisticsCalculator: No data available\n");
+        return;
+    }
+    
+    printf("Statistics Calculator Summary:\n");
+    printf("Data Points: %d\n", calc->count);
+    
+    require_statistics(calc, CACHE_MIN | CACHE_MAX);
+    printf("Min: %d, Max: %d, Range: %d\n", 
+           calc->cache_min, 
+           calc->cache_max, 
+           calculate_range(calc));
+    
+    printf("Mean: %.4f\n", calculate_mean(calc));
+    printf("Median: %.1f\n", calculate_median(calc));
+    
+    int* modes = (int*)malloc((size_t)calc->count * sizeof(int));
+    int mode_count = 0;
+    if (modes != NULL) {
+        calculate_mode(calc, modes, &mode_count);
+    }
+    printf("Mode(s): ");
+    for (int i = 0; i < mode_count; i++) {
+        if (i > 0) printf(", ");
+        printf("%d", modes[i]);
+    }
+    printf("\n");
+    free(modes);
+    
+    if (calc->count >= 2) {
+        printf("Sample Std Dev: %.4f\n", calculate_std_dev(calc, 0));
+    } else {
+        printf("Sample Std Dev: N/A\n");
+    }
+    printf("Population Std Dev: %.4f\n", calculate_std_dev(calc, 1));
+}
+
+// Free calculator
+void free_calculator(StatisticsCalculator* calc) {
+    if (calc != NULL) {
+        if (!sorted_shares_data(calc)) {
+            free(calc->sorted_data);
+        }
+        if (calc->data != calc->inline_values) {
+            free(calc->data);
+        }
+        free(calc->cache_mode);
+        free(calc->histogram);
+        free(calc);
+    }
+}
+
+// Machine-readable summaries. Floats are printed with the shortest digits
+// that read back to the same float (the Ryu algorithm, Adams 2018), so
+// exporters neither lose precision nor pay for printf's formatting.
+#define FORMAT_FLOAT_SIZE 24   // Buffer size that fits any format_float() output
+#define FORMAT_INT_SIZE 21     // Buffer size that fits any format_int() output
+
+typedef struct {
+    int32_t count;
+    int32_t min;
+    int32_t max;
+    int32_t range;
+    float mean;
+    float median;
+    float std_dev_sample;      // NaN with fewer than two values
+    float std_dev_population;
+    int32_t mode_count;        // int32 modes follow the record
+} SummaryRecord;
+
+static const uint64_t FLOAT_POW5_INV_SPLIT[31] = {
+    576460752303423489u, 461168601842738791u, 368934881474191033u,
+    295147905179352826u, 472236648286964522u, 377789318629571618u,
+    302231454903657294u, 483570327845851670u, 386856262276681336u,
+    309485009821345069u, 495176015714152110u, 396140812571321688u,
+    316912650057057351u, 507060240091291761u, 405648192073033409u,
+    324518553658426727u, 519229685853482763u, 415383748682786211u,
+    332306998946228969u, 531691198313966350u, 425352958651173080u,
+    340282366920938464u, 544451787073501542u, 435561429658801234u,
+    348449143727040987u, 557518629963265579u, 446014903970612463u,
+    356811923176489971u, 570899077082383953u, 456719261665907162u,
+    365375409332725730u
+};
+
+static const uint64_t FLOAT_POW5_SPLIT[47] = {
+    1152921504606846976u, 1441151880758558720u, 1801439850948198400u,
+    2251799813685248000u, 1407374883553280000u, 1759218604441600000u,
+    2199023255552000000u, 1374389534720000000u, 1717986918400000000u,
+    2147483648000000000u, 1342177280000000000u, 1677721600000000000u,
+    2097152000000000000u, 1310720000000000000u, 1638400000000000000u,
+    2048000000000000000u, 1280000000000000000u, 1600000000000000000u,
+    2000000000000000000u, 1250000000000000000u, 1562500000000000000u,
+    1953125000000000000u, 1220703125000000000u, 1525878906250000000u,
+    1907348632812500000u, 1192092895507812500u, 1490116119384765625u,
+    1862645149230957031u, 1164153218269348144u, 1455191522836685180u,
+    1818989403545856475u, 2273736754432320594u, 1421085471520200371u,
+    1776356839400250464u, 2220446049250313080u, 1387778780781445675u,
+    1734723475976807094u, 2168404344971008868u, 1355252715606880542u,
+    1694065894508600678u, 2117582368135750847u, 1323488980084844279u,
+    1654361225106055349u, 2067951531382569187u, 1292469707114105741u,
+    1615587133892632177u, 2019483917365790221u
+};
+
+static const char DIGIT_PAIRS[200] = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+static int pow5_bits(int e) { return (int)(((uint32_t)e * 1217359) >> 19) + 1; }
+static int log10_pow2(int e) { return (int)(((uint32_t)e * 78913) >> 18); }
+static int log10_pow5(int e) { return (int)(((uint32_t)e * 732923) >> 20); }
+
+static int multiple_of_pow5(uint32_t value, int p) {
+    int count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+static uint32_t mul_shift32(uint32_t m, uint64_t factor, int shift) {
+    uint64_t low = (uint64_t)m * (uint32_t)factor;
+    uint64_t high = (uint64_t)m * (uint32_t)(factor >> 32);
+    return (uint32_t)(((low >> 32) + high) >> (shift - 32));
+}
+
+// Shortest decimal digits and power of ten that round-trip a finite float
+static void float_to_decimal(uint32_t bits, uint32_t* digits, int* exponent) {
+    uint32_t ieee_mantissa = bits & ((1u << 23) - 1);
+    uint32_t ieee_exponent = (bits >> 23) & 0xFF;
+    int e2;
+    uint32_t m2;
+    if (ieee_exponent == 0) {
+        e2 = 1 - 127 - 23 - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (int)ieee_exponent - 127 - 23 - 2;
+        m2 = (1u << 23) | ieee_mantissa;
+    }
+    int accept_bounds = (m2 & 1) == 0;
+
+    // Scaled value and the halfway points to its neighbours
+    uint32_t mv = 4 * m2;
+    uint32_t mp = 4 * m2 + 2;
+    uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    uint32_t mm = 4 * m2 - 1 - mm_shift;
+
+    uint32_t vr, vp, vm;
+    int e10;
+    int vm_trailing_zeros = 0, vr_trailing_zeros = 0;
+    uint32_t last_removed = 0;
+    if (e2 >= 0) {
+        int q = log10_pow2(e2);
+        e10 = q;
+        int k = 59 + pow5_bits(q) - 1;
+        int i = -e2 + q + k;
+        vr = mul_shift32(mv, FLOAT_POW5_INV_SPLIT[q], i);
+        vp = mul_shift32(mp, FLOAT_POW5_INV_SPLIT[q], i);
+        vm = mul_shift32(mm, FLOAT_POW5_INV_SPLIT[q], i);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            int l = 59 + pow5_bits(q - 1) - 1;
+            last_removed = mul_shift32(mv, FLOAT_POW5_INV_SPLIT[q - 1], -e2 + q - 1 + l) % 10;
+        }
+        if (q <= 9) {
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = multiple_of_pow5(mm, q);
+            } else {
+                vp -= multiple_of_pow5(mp, q);
+            }
+        }
+    } else {
+        int q = log10_pow5(-e2);
+        e10 = q + e2;
+        int i = -e2 - q;
+        int k = pow5_bits(i) - 61;
+        int j = q - k;
+        vr = mul_shift32(mv, FLOAT_POW5_SPLIT[i], j);
+        vp = mul_shift32(mp, FLOAT_POW5_SPLIT[i], j);
+        vm = mul_shift32(mm, FLOAT_POW5_SPLIT[i], j);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            j = q - 1 - (pow5_bits(i + 1) - 61);
+            last_removed = mul_shift32(mv, FLOAT_POW5_SPLIT[i + 1], j) % 10;
+        }
+        if (q <= 1) {
+            vr_trailing_zeros = 1;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 31) {
+            vr_trailing_zeros = (mv & ((1u << (q - 1)) - 1)) == 0;
+        }
+    }
+
+    // Drop digits while the interval still contains a shorter number
+    int removed = 0;
+    uint32_t output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) {
+            last_removed = 4;  // Round half to even
+        }
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        while (vp / 10 > vm / 10) {
+            last_removed = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || last_removed >= 5);
+    }
+    *digits = output;
+    *exponent = e10 + removed;
+}
+
+// Write the decimal digits of `value` to `out` without a terminator; returns the length
+static int write_digits(char* out, uint64_t value) {
+    char buffer[20];
+    char* p = buffer + sizeof(buffer);
+    while (value >= 100) {
+        const char* pair = &DIGIT_PAIRS[(value % 100) * 2];
+        value /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if (value >= 10) {
+        *--p = DIGIT_PAIRS[value * 2 + 1];
+        *--p = DIGIT_PAIRS[value * 2];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    int length = (int)(buffer + sizeof(buffer) - p);
+    memcpy(out, p, (size_t)length);
+    return length;
+}
+
+// Format an integer into `out` (FORMAT_INT_SIZE bytes); returns the length
+int format_int(char* out, long long value) {
+    int length = 0;
+    uint64_t magnitude = (uint64_t)value;
+    if (value < 0) {
+        out[length++] = '-';
+        magnitude = 0 - magnitude;
+    }
+    length += write_digits(out + length, magnitude);
+    out[length] = '\0';
+    return length;
+}
+
+// Format a float with the fewest digits that read back to the same value,
+// in plain notation for moderate magnitudes and d.ddde±x otherwise, into
+// `out` (FORMAT_FLOAT_SIZE bytes); returns the length
+int format_float(char* out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int length = 0;
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        const char* text = (bits & ((1u << 23) - 1)) ? "nan" : (bits >> 31) ? "-inf" : "inf";
+        length = (int)strlen(text);
+        memcpy(out, text, (size_t)length + 1);
+        return length;
+    }
+    if (bits >> 31) {
+        out[length++] = '-';
+    }
+    if ((bits & 0x7FFFFFFFu) == 0) {
+        out[length++] = '0';
+        out[length] = '\0';
+        return length;
+    }
+
+    uint32_t digits;
+    int exponent;
+    float_to_decimal(bits, &digits, &exponent);
+    char text[10];
+    int count = write_digits(text, digits);
+    int point = count + exponent;  // Position of the decimal point within the digits
+    if (point > 9 || point < -3) {
+        out[length++] = text[0];
+        if (count > 1) {
+            out[length++] = '.';
+            memcpy(out + length, text + 1, (size_t)count - 1);
+            length += count - 1;
+        }
+        out[length++] = 'e';
+        length += format_int(out + length, point - 1);
+        return length;
+    }
+    if (point <= 0) {
+        out[length++] = '0';
+        out[length++] = '.';
+        memset(out + length, '0', (size_t)-point);
+        length += -point;
+        memcpy(out + length, text, (size_t)count);
+        length += count;
+    } else if (point < count) {
+        memcpy(out + length, text, (size_t)point);
+        length += point;
+        out[length++] = '.';
+        memcpy(out + length, text + point, (size_t)(count - point));
+        length += count - point;
+    } else {
+        memcpy(out + length, text, (size_t)count);
+        length += count;
+        memset(out + length, '0', (size_t)(point - count));
+        length += point - count;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+// Bounded output: counts every byte but stores only what fits, snprintf-style
+typedef struct {
+    char* buffer;
+    size_t size;
+    size_t length;
+} SummaryWriter;
+
+static void writer_put(SummaryWriter* writer, const void* data, size_t size) {
+    if (writer->length < writer->size) {
+        size_t room = writer->size - writer->length;
+        memcpy(writer->buffer + writer->length, data, size < room ? size : room);
+    }
+    writer->length += size;
+}
+
+static void writer_text(SummaryWriter* writer, const char* text) {
+    writer_put(writer, text, strlen(text));
+}
+
+static void writer_int(SummaryWriter* writer, long long value) {
+    char text[FORMAT_INT_SIZE];
+    writer_put(writer, text, (size_t)format_int(text, value));
+}
+
+static void writer_float(SummaryWriter* writer, float value) {
+    char text[FORMAT_FLOAT_SIZE];
+    if (isfinite(value)) {
+        writer_put(writer, text, (size_t)format_float(text, value));
+    } else {
+        writer_text(writer, "null");  // JSON has no NaN or infinity
+    }
+}
+
+// The calculator's modes, cached when possible; *scratch is set if the
+// result lives in a temporary buffer the caller must free
+static const int* summary_modes(StatisticsCalculator* calc, int small[], int small_size,
+                                int* mode_count, int** scratch) {
+    *scratch = NULL;
+    if (!(calc->cache_flags & CACHE_MODE)) {
+        int* modes = small;
+        if (calc->count > small_size) {
+            modes = *scratch = (int*)malloc((size_t)calc->count * sizeof(int));
+            if (modes == NULL) {
+                printf("Memory allocation failed\n");
+                *mode_count = 0;
+                return NULL;
+            }
+        }
+        calculate_mode(calc, modes, mode_count);
+        if (!(calc->cache_flags & CACHE_MODE)) {
+            return modes;
+        }
+        free(*scratch);
+        *scratch = NULL;
+    }
+    *mode_count = calc->cache_mode_count;
+    return calc->cache_mode;
+}
+
+// Write the summary as a JSON object into `buffer`. Like snprintf, the output
+// is truncated to `size` bytes including the terminator, and the return value
+// is the full length, so a result >= size means the buffer was too small.
+size_t summary_to_json(StatisticsCalculator* calc, char* buffer, size_t size) {
+    SummaryWriter writer = {buffer, size > 0 ? size - 1 : 0, 0};
+    writer_text(&writer, "{\"count\":");
+    writer_int(&writer, calc->count);
+    if (calc->count > 0) {
+        int small[64];
+        int mode_count = 0;
+        int* scratch;
+        const int* modes = summary_modes(calc, small, 64, &mode_count, &scratch);
+        writer_text(&writer, ",\"mean\":");
+        writer_float(&writer, calculate_mean(calc));
+        writer_text(&writer, ",\"median\":");
+        writer_float(&writer, calculate_median(calc));
+        writer_text(&writer, ",\"mode\":[");
+        for (int i = 0; i < mode_count; i++) {
+            if (i > 0) writer_put(&writer, ",", 1);
+            writer_int(&writer, modes[i]);
+        }
+        free(scratch);
+        writer_text(&writer, "],\"std_dev_sample\":");
+        if (calc->count > 1) {
+            writer_float(&writer, calculate_std_dev(calc, 0));
+        } else {
+            writer_text(&writer, "null");
+        }
+        writer_text(&writer, ",\"std_dev_population\":");
+        writer_float(&writer, calculate_std_dev(calc, 1));
+        require_statistics(calc, CACHE_MIN | CACHE_MAX);
+        writer_text(&writer, ",\"min\":");
+        writer_int(&writer, calc->cache_min);
+        writer_text(&writer, ",\"max\":");
+        writer_int(&writer, calc->cache_max);
+        writer_text(&writer, ",\"range\":");
+        writer_int(&writer, calculate_range(calc));
+    }
+    writer_put(&writer, "}", 1);
+    if (size > 0) {
+        buffer[writer.length < size ? writer.length : size - 1] = '\0';
+    }
+    return writer.length;
+}
+
+// Write the summary as a SummaryRecord followed by its modes (host byte
+// order). Returns the full size; nothing past `size` bytes is written.
+size_t summary_to_binary(StatisticsCalculator* calc, void* buffer, size_t size) {
+    SummaryWriter writer = {(char*)buffer, size, 0};
+    SummaryRecord record;
+    memset(&record, 0, sizeof(record));
+    record.count = calc->count;
+    if (calc->count == 0) {
+        record.mean = record.median = record.std_dev_sample = record.std_dev_population = NAN;
+        writer_put(&writer, &record, sizeof(record));
+        return writer.length;
+    }
+    int small[64];
+    int* scratch;
+    const int* modes = summary_modes(calc, small, 64, &record.mode_count, &scratch);
+    record.mean = calculate_mean(calc);
+    record.median = calculate_median(calc);
+    record.std_dev_sample = calc->count > 1 ? calculate_std_dev(calc, 0) : NAN;
+    record.std_dev_population = calculate_std_dev(calc, 1);
+    record.range = calculate_range(calc);
+    require_statistics(calc, CACHE_MIN | CACHE_MAX);
+    record.min = calc->cache_min;
+    record.max = calc->cache_max;
+    writer_put(&writer, &record, sizeof(record));
+    writer_put(&writer, modes, (size_t)record.mode_count * sizeof(int));
+    free(scratch);
+    return writer.length;
+}
+
+// OpenMetrics exposition. Each calculator becomes one labelled series of a
+// summary family (quantiles, sum, count) and of a histogram family
+// (<family>_distribution: cumulative buckets, sum, count). Everything comes
+// from the cached sum and sorted data, so scraping unchanged calculators
+// does no recomputation.
+typedef struct {
+    const float* quantiles;    // Each in [0, 1]
+    int quantile_count;
+    const float* buckets;      // Ascending upper bounds; +Inf is implicit
+    int bucket_count;
+} MetricsLayout;
+
+static const float DEFAULT_METRICS_QUANTILES[] = {0.5f, 0.9f, 0.99f};
+
+static void writer_label_value(SummaryWriter* writer, const char* value) {
+    for (const char* p = value; *p; p++) {
+        if (*p == '\\' || *p == '"') {
+            char escaped[2] = {'\\', *p};
+            writer_put(writer, escaped, 2);
+        } else if (*p == '\n') {
+            writer_put(writer, "\\n", 2);
+        } else {
+            writer_put(writer, p, 1);
+        }
+    }
+}
+
+// Start a sample line: name{calculator="...",extra="..."} and a space
+static void writer_sample(SummaryWriter* writer, const char* family, const char* suffix,
+                          const char* calculator, const char* extra_label, const char* extra_value) {
+    writer_text(writer, family);
+    writer_text(writer, suffix);
+    writer_text(writer, "{calculator=\"");
+    writer_label_value(writer, calculator);
+    if (extra_label != NULL) {
+        writer_text(writer, "\",");
+        writer_text(writer, extra_label);
+        writer_text(writer, "=\"");
+        writer_text(writer, extra_value);
+    }
+    writer_text(writer, "\"} ");
+}
+
+// Number of sorted values <= bound
+static int count_at_most(const int sorted[], int count, float bound) {
+    int low = 0, high = count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if ((double)sorted[mid] <= (double)bound) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Render `count` calculators, labelled calculator="<names[i]>", as a complete
+// OpenMetrics exposition ending in "# EOF". A NULL layout gives the median,
+// 0.9 and 0.99 quantiles and only the +Inf bucket. Sizing works like
+// summary_to_json().
+size_t write_openmetrics(const char* family, const char* const names[], StatisticsCalculator* const calcs[],
+                         int count, const MetricsLayout* layout, char* buffer, size_t size) {
+    MetricsLayout defaults = {DEFAULT_METRICS_QUANTILES, 3, NULL, 0};
+    if (layout == NULL) {
+        layout = &defaults;
+    }
+    SummaryWriter writer = {buffer, size > 0 ? size - 1 : 0, 0};
+    char number[FORMAT_FLOAT_SIZE];
+
+    writer_text(&writer, "# TYPE ");
+    writer_text(&writer, family);
+    writer_text(&writer, " summary\n# HELP ");
+    writer_text(&writer, family);
+    writer_text(&writer, " Samples held by each calculator.\n");
+    for (int i = 0; i < count; i++) {
+        StatisticsCalculator* calc = calcs[i];
+        if (calc->count > 0) {
+            sort_data(calc);
+            for (int q = 0; q < layout->quantile_count; q++) {
+                format_float(number, layout->quantiles[q]);
+                writer_sample(&writer, family, "", names[i], "quantile", number);
+                writer_float(&writer, calculate_percentile(calc, layout->quantiles[q] * 100.0f));
+                writer_put(&writer, "\n", 1);
+            }
+        }
+        writer_sample(&writer, family, "_sum", names[i], NULL, NULL);
+        writer_int(&writer, calculate_sum(calc));
+        writer_put(&writer, "\n", 1);
+        writer_sample(&writer, family, "_count", names[i], NULL, NULL);
+        writer_int(&writer, calc->count);
+        writer_put(&writer, "\n", 1);
+    }
+
+    writer_text(&writer, "# TYPE ");
+    writer_text(&writer, family);
+    writer_text(&writer, "_distribution histogram\n# HELP ");
+    writer_text(&writer, family);
+    writer_text(&writer, "_distribution Distribution of the samples held by each calculator.\n");
+    for (int i = 0; i < count; i++) {
+        StatisticsCalculator* calc = calcs[i];
+        if (calc->count > 0) {
+            sort_data(calc);
+        }
+        for (int b = 0; b < layout->bucket_count; b++) {
+            format_float(number, layout->buckets[b]);
+            writer_sample(&writer, family, "_distribution_bucket", names[i], "le", number);
+            writer_int(&writer, calc->count > 0 ? count_at_most(calc->sorted_data, calc->count,
+                                                                layout->buckets[b]) : 0);
+            writer_put(&writer, "\n", 1);
+        }
+        writer_sample(&writer, family, "_distribution_bucket", names[i], "le", "+Inf");
+        writer_int(&writer, calc->count);
+        writer_put(&writer, "\n", 1);
+        writer_sample(&writer, family, "_distribution_sum", names[i], NULL, NULL);
+        writer_int(&writer, calculate_sum(calc));
+        writer_put(&writer, "\n", 1);
+        writer_sample(&writer, family, "_distribution_count", names[i], NULL, NULL);
+        writer_int(&writer, calc->count);
+        writer_put(&writer, "\n", 1);
+    }
+    writer_text(&writer, "# EOF\n");
+    if (size > 0) {
+        buffer[writer.length < size ? writer.length : size - 1] = '\0';
+    }
+    return writer.length;
+}
+
+// Checkpoint file layout: a fixed header in host byte order followed by the
+// data, sorted data, cached modes and histogram, each section starting on a
+// 64-byte boundary so the file can be mapped and used in place.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Checkpoints are written and mapped in host byte order, which must be little-endian"
+#endif
+#define CHECKPOINT_MAGIC "MPSTATS"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_ALIGN 64
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int32_t count;
+    int32_t sorted_count;
+    int32_t cache_mode_count;
+    int32_t cache_flags;
+    float cache_mean;
+    float cache_median;
+    float cache_std_dev_sample;
+    float cache_std_dev_population;
+    int32_t cache_range;
+    int32_t histogram_base;
+    int32_t histogram_span;  // 0 when the histogram is not saved
+    uint32_t reserved;
+    uint64_t data_offset;
+    uint64_t sorted_offset;
+    uint64_t mode_offset;
+    uint64_t histogram_offset;
+    uint64_t file_size;
+    uint64_t wal_lsn;    // Last write-ahead log record included in this state
+    uint64_t data_version;
+} CheckpointHeader;
+
+static uint64_t checkpoint_align(uint64_t offset) {
+    return (offset + CHECKPOINT_ALIGN - 1) & ~(uint64_t)(CHECKPOINT_ALIGN - 1);
+}
+
+static int write_section(FILE* file, uint64_t* pos, uint64_t offset, const void* data, size_t size) {
+    static const char padding[CHECKPOINT_ALIGN] = {0};
+    if (fwrite(padding, 1, (size_t)(offset - *pos), file) != offset - *pos ||
+        (size > 0 && fwrite(data, 1, size, file) != size)) {
+        return -1;
+    }
+    *pos = offset + size;
+    return 0;
+}
+
+static int save_checkpoint(const StatisticsCalculator* calc, const char* path, uint64_t wal_lsn) {
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.header_size = sizeof(header);
+    header.count = calc->count;
+    header.sorted_count = calc->sorted_count;
+    header.cache_mode_count = (calc->cache_flags & CACHE_MODE) ? calc->cache_mode_count : 0;
+    header.cache_flags = calc->cache_flags & CACHE_PERSISTED;
+    header.cache_mean = calc->cache_mean;
+    header.cache_median = calc->cache_median;
+    header.cache_std_dev_sample = calc->cache_std_dev_sample;
+    header.cache_std_dev_population = calc->cache_std_dev_population;
+    header.cache_range = calc->cache_range;
+    if (calc->cache_flags & CACHE_HISTOGRAM) {
+        header.histogram_base = calc->histogram_base;
+        header.histogram_span = calc->histogram_span;
+    }
+    header.wal_lsn = wal_lsn;
+    header.data_version = calc->version;
+
+    size_t data_size = (size_t)calc->count * sizeof(int);
+    size_t sorted_size = (size_t)calc->sorted_count * sizeof(int);
+    size_t mode_size = (size_t)header.cache_mode_count * sizeof(int);
+    size_t histogram_size = (size_t)header.histogram_span * sizeof(int);
+    header.data_offset = checkpoint_align(sizeof(header));
+    header.sorted_offset = checkpoint_align(header.data_offset + data_size);
+    header.mode_offset = checkpoint_align(header.sorted_offset + sorted_size);
+    header.histogram_offset = checkpoint_align(header.mode_offset + mode_size);
+    header.file_size = header.histogram_offset + histogram_size;
+
+    size_t tmp_len = strlen(path) + 5;
+    char* tmp_path = (char*)malloc(tmp_len);
+    if (tmp_path == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    FILE* file = fopen(tmp_path, "wb");
+    if (file == NULL) {
+        printf("Error: Cannot write checkpoint %s\n", tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+    uint64_t pos = 0;
+    int status = write_section(file, &pos, 0, &header, sizeof(header));
+    if (status == 0) status = write_section(file, &pos, header.data_offset, calc->data, data_size);
+    if (status == 0) status = write_section(file, &pos, header.sorted_offset, calc->sorted_data, sorted_size);
+    if (status == 0) status = write_section(file, &pos, header.mode_offset, calc->cache_mode, mode_size);
+    if (status == 0) {
+        status = write_section(file, &pos, header.histogram_offset, calc->histogram, histogram_size);
+    }
+    if (status == 0 && (fflush(file) != 0 || fsync(fileno(file)) != 0)) {
+        status = -1;
+    }
+    if (fclose(file) != 0) {
+        status = -1;
+    }
+    if (status == 0 && rename(tmp_path, path) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        printf("Error: Cannot write checkpoint %s\n", path);
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    return status;
+}
+
+// Save the full calculator state; the file is replaced atomically
+int save_calculator(const StatisticsCalculator* calc, const char* path) {
+    return save_checkpoint(calc, path, 0);
+}
+
+static int read_section(FILE* file, uint64_t offset, void* data, size_t size) {
+    return size == 0 || (fseeko(file, (off_t)offset, SEEK_SET) == 0 && fread(data, 1, size, file) == size)
+               ? 0 : -1;
+}
+
+static StatisticsCalculator* load_checkpoint(const char* path, uint64_t* wal_lsn) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        printf("Error: Cannot open checkpoint %s\n", path);
+        return NULL;
+    }
+    CheckpointHeader header;
+    StatisticsCalculator* calc = NULL;
+    int valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0 &&
+                header.version == CHECKPOINT_VERSION && header.header_size == sizeof(header) &&
+                header.data_version > 0 && header.count >= 0 && header.sorted_count >= 0 && header.sorted_count <= header.count &&
+                header.cache_mode_count >= 0 && header.cache_mode_count <= header.count &&
+                header.data_offset >= header.header_size &&
+                header.sorted_offset >= header.data_offset + (uint64_t)header.count * sizeof(int) &&
+                header.mode_offset >= header.sorted_offset + (uint64_t)header.sorted_count * sizeof(int) &&
+                header.histogram_offset >= header.mode_offset + (uint64_t)header.cache_mode_count * sizeof(int) &&
+                header.histogram_span >= 0 && header.histogram_span <= HISTOGRAM_MAX_SPAN &&
+                (long long)header.histogram_base + header.histogram_span - 1 <= INT_MAX &&
+                (header.histogram_span == 0 || header.count > 0) &&
+                header.file_size == header.histogram_offset + (uint64_t)header.histogram_span * sizeof(int);
+    if (valid) {
+        calc = create_calculator();
+    }
+    if (calc != NULL && header.count > 0) {
+        calc->sorted_data = (int*)malloc((size_t)header.count * sizeof(int));
+        calc->cache_mode = (int*)malloc((size_t)(header.cache_mode_count > 0 ? header.cache_mode_count : 1) *
+                                        sizeof(int));
+        calc->histogram = header.histogram_span > 0 ? (int*)malloc((size_t)header.histogram_span * sizeof(int))
+                                                    : NULL;
+        if (reserve_capacity(calc, header.count) != 0 || calc->sorted_data == NULL ||
+            calc->cache_mode == NULL || (header.histogram_span > 0 && calc->histogram == NULL)) {
+            free_calculator(calc);
+            calc = NULL;
+        }
+    }
+    if (calc != NULL &&
+        (read_section(file, header.data_offset, calc->data, (size_t)header.count * sizeof(int)) != 0 ||
+         read_section(file, header.sorted_offset, calc->sorted_data,
+                      (size_t)header.sorted_count * sizeof(int)) != 0 ||
+         read_section(file, header.mode_offset, calc->cache_mode,
+                      (size_t)header.cache_mode_count * sizeof(int)) != 0 ||
+         read_section(file, header.histogram_offset, calc->histogram,
+                      (size_t)header.histogram_span * sizeof(int)) != 0)) {
+        free_calculator(calc);
+        calc = NULL;
+        valid = 0;
+    }
+    if (calc != NULL && header.histogram_span > 0) {
+        // Rank lookups walk the bins, so they must count exactly the data
+        long long counted = 0;
+        for (int i = 0; i < header.histogram_span && counted >= 0; i++) {
+            counted = calc->histogram[i] < 0 ? -1 : counted + calc->histogram[i];
+        }
+        if (counted != header.count) {
+            free_calculator(calc);
+            calc = NULL;
+            valid = 0;
+        }
+    }
+    fclose(file);
+    if (calc == NULL) {
+        if (!valid) {
+            printf("Error: Invalid checkpoint %s\n", path);
+        }
+        return NULL;
+    }
+    calc->count = header.count;
+    calc->sorted_count = header.sorted_count;
+    calc->cache_mode_count = header.cache_mode_count;
+    calc->cache_flags = header.cache_flags & CACHE_PERSISTED;
+    if (header.count > 0 && header.sorted_count == header.count) {
+        calc->cache_flags |= CACHE_SORTED;
+    } else {
+        calc->sorted_count = 0;
+    }
+    calc->cache_mean = header.cache_mean;
+    calc->cache_median = header.cache_median;
+    calc->cache_std_dev_sample = header.cache_std_dev_sample;
+    calc->cache_std_dev_population = header.cache_std_dev_population;
+    calc->cache_range = header.cache_range;
+    if (header.histogram_span > 0) {
+        calc->histogram_base = header.histogram_base;
+        calc->histogram_span = header.histogram_span;
+        calc->cache_flags |= CACHE_HISTOGRAM;
+    }
+    calc->version = header.data_version;
+    if (wal_lsn != NULL) {
+        *wal_lsn = header.wal_lsn;
+    }
+    return calc;
+}
+
+// Restore a calculator saved by save_calculator(); cached statistics, the
+// sorted order and the histogram are valid immediately, without replaying or
+// re-sorting
+StatisticsCalculator* load_calculator(const char* path) {
+    return load_checkpoint(path, NULL);
+}
+
+// Write-ahead log: an append-only file of ingested batches, so a calculator can
+// be rebuilt after a crash from its last checkpoint plus the log tail. The file
+// starts with a WalFileHeader; each record is a WalRecordHeader followed by the
+// batch values. Small batches are grouped in memory and written together, and
+// fsync follows the configured policy (group commit).
+#define WAL_MAGIC "MPWAL"
+#define WAL_VERSION 1
+#define WAL_DEFAULT_GROUP_BYTES (1 << 20)
+#define WAL_MAX_RECORD_VALUES (1 << 28)
+
+typedef enum {
+    WAL_SYNC_NONE,      // Leave write-back to the OS
+    WAL_SYNC_COMMIT,    // fsync every group written to the file
+    WAL_SYNC_INTERVAL   // fsync at most once per sync interval
+} WalSyncPolicy;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t base_lsn;   // LSN of the first record; earlier ones are in a checkpoint
+} WalFileHeader;
+
+typedef struct {
+    uint32_t payload_size;
+    uint32_t crc;        // CRC-32C of lsn and payload
+    uint64_t lsn;
+} WalRecordHeader;
+
+typedef struct {
+    char* path;
+    int fd;
+    off_t file_size;     // End of the last complete record
+    WalSyncPolicy sync_policy;
+    double sync_interval;
+    double last_sync;
+    int unsynced;        // Records written since the last fsync
+    unsigned char* buffer;
+    size_t buffered;
+    size_t group_bytes;
+    uint64_t next_lsn;
+} WriteAheadLog;
+
+WriteAheadLog* open_wal(const char* path, WalSyncPolicy policy, int sync_interval_ms, size_t group_bytes);
+int wal_add_values(WriteAheadLog* wal, StatisticsCalculator* calc, const int values[], int count);
+int wal_commit(WriteAheadLog* wal);
+int wal_sync(WriteAheadLog* wal);
+int checkpoint_calculator(StatisticsCalculator* calc, WriteAheadLog* wal, const char* checkpoint_path);
+int close_wal(WriteAheadLog* wal);
+StatisticsCalculator* recover_calculator(const char* checkpoint_path, const char* wal_path);
+
+static uint32_t crc32c_table[256];
+
+static uint32_t crc32c_software(uint32_t crc, const unsigned char* p, size_t n) {
+    if (crc32c_table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1)));
+            }
+            crc32c_table[i] = c;
+        }
     }
-    init_calculator(calc);
-    return calc;
+    while (n--) {
+        crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
 }
 
-// Initialize calculator data
-void init_calculator(StatisticsCalculator* calc) {
-    calc->count = 0;
-    calc->sorted_count = 0;
-    calc->cache_flags = 0;
-    calc->cache_mode_count = 0;
-    memset(calc->data, 0, sizeof(calc->data));
-    memset(calc->sorted_data, 0, sizeof(calc->sorted_data));
-    memset(calc->cache_mode, 0, sizeof(calc->cache_mode));
-}
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
 
-// Add a single value
-void add_value(StatisticsCalculator* calc, int value) {
-    if (calc->count < MAX_DATA_SIZE) {
-        calc->data[calc->count++] = value;
-        calc->sorted_count = 0;  // Invalidate sorted data
-        calc->cache_flags = 0;   // Clear all cache flags
-    } else {
-        printf("Error: Data size limit (%d) exceeded\n", MAX_DATA_SIZE);
+// The SSE4.2 crc32 instruction keeps checksumming off the ingest critical path
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char* p, size_t n) {
+    uint64_t c = crc;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        c = _mm_crc32_u64(c, word);
     }
+    crc = (uint32_t)c;
+    while (n--) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return crc;
 }
+#endif
 
-// Add multiple values
-void add_values(StatisticsCalculator* calc, int values[], int count) {
-    for (int i = 0; i < count; i++) {
-        add_value(calc, values[i]);
+// CRC-32C of `size` bytes, continuing from a previous result
+static uint32_t crc32c(uint32_t crc, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return ~crc32c_sse42(~crc, p, size);
     }
+#endif
+    return ~crc32c_software(~crc, p, size);
 }
 
-// Clear all data and cache
-void clear_data(StatisticsCalculator* calc) {
-    init_calculator(calc);
+static uint32_t wal_record_crc(uint64_t lsn, const void* payload, size_t size) {
+    return crc32c(crc32c(0, &lsn, sizeof(lsn)), payload, size);
 }
 
-// Sort data for median and range calculations
-void sort_data(StatisticsCalculator* calc) {
-    if (calc->sorted_count == 0 && calc->count > 0) {
-        memcpy(calc->sorted_data, calc->data, calc->count * sizeof(int));
-        qsort(calc->sorted_data, calc->count, sizeof(int), compare_ints);
-        calc->sorted_count = calc->count;
-    }
+static double wal_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
 }
 
-// Calculate mean
-float calculate_mean(StatisticsCalculator* calc) {
-    if (calc->cache_flags & CACHE_MEAN) {
-        return calc->cache_mean;
-    }
-    
-    if (calc->count == 0) {
-        printf("Error: Cannot calculate mean - data is empty\n");
-        return 0.0f;
-    }
-    
-    int sum = 0;
-    for (int i = 0; i < calc->count; i++) {
-        sum += calc->data[i];
+// Write every byte of the vectors, resuming after short writes and EINTR
+static int wal_write_all(int fd, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t written = writev(fd, iov, iovcnt);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+            written -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + written;
+            iov->iov_len -= (size_t)written;
+        }
     }
-    
-    calc->cache_mean = (float)sum / calc->count;
-    calc->cache_flags |= CACHE_MEAN;
-    return calc->cache_mean;
+    return 0;
 }
 
-// Calculate median
-float calculate_median(StatisticsCalculator* calc) {
-    if (calc->cache_flags & CACHE_MEDIAN) {
-        return calc->cache_median;
+// Append whole records; a failed write is cut back so the log never keeps a torn record
+static int wal_append(WriteAheadLog* wal, struct iovec* iov, int iovcnt, size_t size) {
+    if (wal_write_all(wal->fd, iov, iovcnt) != 0) {
+        if (ftruncate(wal->fd, wal->file_size) != 0 || lseek(wal->fd, wal->file_size, SEEK_SET) < 0) {
+            printf("Error: Cannot roll back write-ahead log %s\n", wal->path);
+        }
+        printf("Error: Cannot write write-ahead log %s\n", wal->path);
+        return -1;
     }
-    
-    if (calc->count == 0) {
-        printf("Error: Cannot calculate median - data is empty\n");
-        return 0.0f;
+    wal->file_size += (off_t)size;
+    wal->unsynced = 1;
+    return 0;
+}
+
+int wal_sync(WriteAheadLog* wal) {
+    if (wal->unsynced) {
+        if (fdatasync(wal->fd) != 0) {
+            printf("Error: Cannot sync write-ahead log %s\n", wal->path);
+            return -1;
+        }
+        wal->unsynced = 0;
     }
-    
-    sort_data(calc);
-    int n = calc->count;
-    float median;
-    
-    if (n % 2 == 0) {
-        // Even number of elements
-        median = (calc->sorted_data[n/2 - 1] + calc->sorted_data[n/2]) / 2.0f;
-    } else {
-        // Odd number of elements
-        median = (float)calc->sorted_data[n/2];
+    wal->last_sync = wal_now();
+    return 0;
+}
+
+static int wal_apply_sync_policy(WriteAheadLog* wal) {
+    switch (wal->sync_policy) {
+        case WAL_SYNC_COMMIT:
+            return wal_sync(wal);
+        case WAL_SYNC_INTERVAL:
+            return wal_now() - wal->last_sync >= wal->sync_interval ? wal_sync(wal) : 0;
+        default:
+            return 0;
     }
-    
-    calc->cache_median = median;
-    calc->cache_flags |= CACHE_MEDIAN;
-    return median;
 }
 
-// Calculate mode
-void calculate_mode(StatisticsCalculator* calc, int modes[], int* mode_count) {
-    if (calc->cache_flags & CACHE_MODE) {
-        memcpy(modes, calc->cache_mode, calc->cache_mode_count * sizeof(int));
-        *mode_count = calc->cache_mode_count;
-        return;
+static int wal_flush_buffer(WriteAheadLog* wal) {
+    if (wal->buffered == 0) {
+        return 0;
     }
-    
-    if (calc->count == 0) {
-        printf("Error: Cannot calculate mode - data is empty\n");
-        *mode_count = 0;
-        return;
+    struct iovec iov = {wal->buffer, wal->buffered};
+    size_t size = wal->buffered;
+    wal->buffered = 0;
+    return wal_append(wal, &iov, 1, size);
+}
+
+// Walk the complete, checksummed records of a log, adding those after
+// `after_lsn` to `calc` when it is given. Stops at the first torn or corrupt
+// record and returns the offset just past the last good one, or -1 when the
+// file is not a write-ahead log.
+static off_t wal_scan(int fd, uint64_t after_lsn, StatisticsCalculator* calc, uint64_t* next_lsn) {
+    WalFileHeader file_header;
+    if (pread(fd, &file_header, sizeof(file_header), 0) != (ssize_t)sizeof(file_header) ||
+        memcmp(file_header.magic, WAL_MAGIC, sizeof(WAL_MAGIC)) != 0 ||
+        file_header.version != WAL_VERSION || file_header.header_size != sizeof(file_header) ||
+        file_header.base_lsn == 0) {
+        return -1;
     }
-    
-    sort_data(calc);
-    
-    int max_freq = 0;
-    int freq = 1;
-    *mode_count = 0;
-    
-    // First pass: find maximum frequency
-    for (int i = 0; i < calc->count; i++) {
-        if (i > 0 && calc->sorted_data[i] != calc->sorted_data[i-1]) {
-            if (freq > max_freq) {
-                max_freq = freq;
+    off_t end = lseek(fd, 0, SEEK_END);
+    off_t offset = sizeof(file_header);
+    uint64_t lsn = file_header.base_lsn;
+    int* values = NULL;
+    size_t values_size = 0;
+    WalRecordHeader record;
+    while (end - offset >= (off_t)sizeof(record) &&
+           pread(fd, &record, sizeof(record), offset) == (ssize_t)sizeof(record)) {
+        size_t size = record.payload_size;
+        if (record.lsn < lsn || size == 0 || size % sizeof(int) != 0 ||
+            size / sizeof(int) > WAL_MAX_RECORD_VALUES ||
+            end - offset - (off_t)sizeof(record) < (off_t)size) {
+            break;
+        }
+        if (size > values_size) {
+            int* grown = (int*)realloc(values, size);
+            if (grown == NULL) {
+                printf("Memory allocation failed\n");
+                break;
             }
-            freq = 1;
-        } else if (i > 0) {
-            freq++;
+            values = grown;
+            values_size = size;
+        }
+        if (pread(fd, values, size, offset + (off_t)sizeof(record)) != (ssize_t)size ||
+            wal_record_crc(record.lsn, values, size) != record.crc) {
+            break;
         }
+        if (calc != NULL && record.lsn > after_lsn) {
+            add_values(calc, values, (int)(size / sizeof(int)));
+        }
+        offset += (off_t)(sizeof(record) + size);
+        lsn = record.lsn + 1;
     }
-    if (freq > max_freq) {
-        max_freq = freq;
+    free(values);
+    if (next_lsn != NULL) {
+        *next_lsn = lsn;
     }
-    
-    // Second pass: collect all values with maximum frequency
-    freq = 1;
-    for (int i = 0; i < calc->count; i++) {
-        if (i > 0 && calc->sorted_data[i] != calc->sorted_data[i-1]) {
-            if (freq == max_freq) {
-                modes[*mode_count] = calc->sorted_data[i-1];
-                (*mode_count)++;
-            }
-            freq = 1;
-        } else if (i > 0) {
-            freq++;
+    return offset;
+}
+
+// Create an empty log whose first record will be `base_lsn`, replacing `path` atomically
+static int wal_create_file(const char* path, uint64_t base_lsn) {
+    size_t tmp_len = strlen(path) + 5;
+    char* tmp_path = (char*)malloc(tmp_len);
+    if (tmp_path == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    snprintf(tmp_path, tmp_len, "%s.tmp", path);
+    WalFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WAL_MAGIC, sizeof(WAL_MAGIC));
+    header.version = WAL_VERSION;
+    header.header_size = sizeof(header);
+    header.base_lsn = base_lsn;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    int status = -1;
+    if (fd >= 0) {
+        struct iovec iov = {&header, sizeof(header)};
+        status = wal_write_all(fd, &iov, 1) == 0 && fsync(fd) == 0 ? 0 : -1;
+        if (close(fd) != 0) {
+            status = -1;
         }
     }
-    if (freq == max_freq) {
-        modes[*mode_count] = calc->sorted_data[calc->count-1];
-        (*mode_count)++;
+    if (status == 0 && rename(tmp_path, path) != 0) {
+        status = -1;
     }
-    
-    memcpy(calc->cache_mode, modes, *mode_count * sizeof(int));
-    calc->cache_mode_count = *mode_count;
-    calc->cache_flags |= CACHE_MODE;
+    if (status != 0) {
+        printf("Error: Cannot create write-ahead log %s\n", path);
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    return status;
 }
 
-// Calculate standard deviation
-float calculate_std_dev(StatisticsCalculator* calc, int population) {
-    if (calc->count == 0) {
-        printf("Error: Cannot calculate standard deviation - data is empty\n");
-        return 0.0f;
+// Open a log for appending, creating it if needed. A torn record left by a
+// crash is cut off, so call recover_calculator() first to replay the log.
+// group_bytes of 0 selects WAL_DEFAULT_GROUP_BYTES.
+WriteAheadLog* open_wal(const char* path, WalSyncPolicy policy, int sync_interval_ms, size_t group_bytes) {
+    if (access(path, F_OK) != 0 && wal_create_file(path, 1) != 0) {
+        return NULL;
     }
-    
-    if (!population && calc->count < 2) {
-        printf("Error: Need at least 2 data points for sample standard deviation\n");
-        return 0.0f;
+    WriteAheadLog* wal = (WriteAheadLog*)calloc(1, sizeof(WriteAheadLog));
+    if (wal == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
     }
-    
-    int cache_flag = population ? CACHE_STD_DEV_POPULATION : CACHE_STD_DEV_SAMPLE;
-    if (calc->cache_flags & cache_flag) {
-        return population ? calc->cache_std_dev_population : calc->cache_std_dev_sample;
+    wal->group_bytes = group_bytes > 0 ? group_bytes : WAL_DEFAULT_GROUP_BYTES;
+    wal->path = strdup(path);
+    wal->buffer = (unsigned char*)malloc(wal->group_bytes);
+    wal->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (wal->path == NULL || wal->buffer == NULL || wal->fd < 0) {
+        printf("Error: Cannot open write-ahead log %s\n", path);
+        close_wal(wal);
+        return NULL;
     }
-    
-    float mean = calculate_mean(calc);
-    float variance = 0.0f;
-    
-    for (int i = 0; i < calc->count; i++) {
-        float diff = calc->data[i] - mean;
-        variance += diff * diff;
+    wal->file_size = wal_scan(wal->fd, 0, NULL, &wal->next_lsn);
+    if (wal->file_size < 0 || ftruncate(wal->fd, wal->file_size) != 0 ||
+        lseek(wal->fd, wal->file_size, SEEK_SET) < 0) {
+        printf("Error: Invalid write-ahead log %s\n", path);
+        close_wal(wal);
+        return NULL;
     }
-    
-    int divisor = population ? calc->count : (calc->count - 1);
-    variance /= divisor;
-    float std_dev = sqrtf(variance);
-    
-    if (population) {
-        calc->cache_std_dev_population = std_dev;
+    wal->sync_policy = policy;
+    wal->sync_interval = sync_interval_ms / 1000.0;
+    wal->last_sync = wal_now();
+    return wal;
+}
+
+// Log a batch, then add it to the calculator. The batch may wait in the group
+// buffer until the next wal_commit(); batches of group_bytes or more are
+// written straight from `values`.
+int wal_add_values(WriteAheadLog* wal, StatisticsCalculator* calc, const int values[], int count) {
+    if (count <= 0) {
+        return 0;
+    }
+    if (count > WAL_MAX_RECORD_VALUES || count > INT_MAX - calc->count) {
+        printf("Error: Batch too large for write-ahead log\n");
+        return -1;
+    }
+    WalRecordHeader record;
+    record.payload_size = (uint32_t)count * sizeof(int);
+    record.lsn = wal->next_lsn;
+    record.crc = wal_record_crc(record.lsn, values, record.payload_size);
+    size_t size = sizeof(record) + record.payload_size;
+
+    if (wal->buffered + size > wal->group_bytes && wal_flush_buffer(wal) != 0) {
+        return -1;
+    }
+    if (size > wal->group_bytes) {
+        struct iovec iov[2] = {{&record, sizeof(record)}, {(void*)values, record.payload_size}};
+        if (wal_append(wal, iov, 2, size) != 0 || wal_apply_sync_policy(wal) != 0) {
+            return -1;
+        }
     } else {
-        calc->cache_std_dev_sample = std_dev;
+        memcpy(wal->buffer + wal->buffered, &record, sizeof(record));
+        memcpy(wal->buffer + wal->buffered + sizeof(record), values, record.payload_size);
+        wal->buffered += size;
     }
-    calc->cache_flags |= cache_flag;
-    
-    return std_dev;
+    wal->next_lsn++;
+    add_values(calc, values, count);
+    return 0;
 }
 
-// Calculate range
-int calculate_range(StatisticsCalculator* calc) {
-    if (calc->cache_flags & CACHE_RANGE) {
-        return calc->cache_range;
-    }
-    
-    if (calc->count == 0) {
-        printf("Error: Cannot calculate range - data is empty\n");
-        return 0;
+// Write the grouped batches to the log and sync according to the policy
+int wal_commit(WriteAheadLog* wal) {
+    if (wal_flush_buffer(wal) != 0) {
+        return -1;
     }
-    
-    sort_data(calc);
-    int range = calc->sorted_data[calc->count - 1] - calc->sorted_data[0];
-    
-    calc->cache_range = range;
-    calc->cache_flags |= CACHE_RANGE;
-    return range;
+    return wal_apply_sync_policy(wal);
 }
 
-// Print summary statistics
-void print_summary(StatisticsCalculator* calc) {
-    if (calc->count == 0) {
-        printf("StatisticsCalculator: No data available\n");
-        return;
+// Checkpoint the calculator and start an empty log after it
+int checkpoint_calculator(StatisticsCalculator* calc, WriteAheadLog* wal, const char* checkpoint_path) {
+    if (wal_flush_buffer(wal) != 0 || wal_sync(wal) != 0 ||
+        save_checkpoint(calc, checkpoint_path, wal->next_lsn - 1) != 0 ||
+        wal_create_file(wal->path, wal->next_lsn) != 0) {
+        return -1;
     }
-    
-    printf("Statistics Calculator Summary:\n");
-    printf("Data Points: %d\n", calc->count);
-    
-    sort_data(calc);
-    printf("Min: %d, Max: %d, Range: %d\n", 
-           calc->sorted_data[0], 
-           calc->sorted_data[calc->count - 1], 
-           calculate_range(calc));
-    
-    printf("Mean: %.4f\n", calculate_mean(calc));
-    printf("Median: %.1f\n", calculate_median(calc));
-    
-    int modes[MAX_DATA_SIZE];
-    int mode_count = 0;
-    calculate_mode(calc, modes, &mode_count);
-    printf("Mode(s): ");
-    for (int i = 0; i < mode_count; i++) {
-        if (i > 0) printf(", ");
-        printf("%d", modes[i]);
+    int fd = open(wal->path, O_RDWR | O_CLOEXEC);
+    if (fd < 0 || lseek(fd, sizeof(WalFileHeader), SEEK_SET) < 0) {
+        printf("Error: Cannot open write-ahead log %s\n", wal->path);
+        if (fd >= 0) close(fd);
+        return -1;
     }
-    printf("\n");
-    
-    if (calc->count >= 2) {
-        printf("Sample Std Dev: %.4f\n", calculate_std_dev(calc, 0));
-    } else {
-        printf("Sample Std Dev: N/A\n");
+    close(wal->fd);
+    wal->fd = fd;
+    wal->file_size = sizeof(WalFileHeader);
+    wal->unsynced = 0;
+    return 0;
+}
+
+// Commit pending batches, sync unless the policy is WAL_SYNC_NONE, and close
+int close_wal(WriteAheadLog* wal) {
+    if (wal == NULL) {
+        return 0;
     }
-    printf("Population Std Dev: %.4f\n", calculate_std_dev(calc, 1));
+    int status = 0;
+    if (wal->fd >= 0) {
+        if (wal_flush_buffer(wal) != 0 || (wal->sync_policy != WAL_SYNC_NONE && wal_sync(wal) != 0)) {
+            status = -1;
+        }
+        if (close(wal->fd) != 0) {
+            status = -1;
+        }
+    }
+    free(wal->buffer);
+    free(wal->path);
+    free(wal);
+    return status;
 }
 
-// Free calculator
-void free_calculator(StatisticsCalculator* calc) {
-    if (calc != NULL) {
-        free(calc);
+// Rebuild a calculator from its last checkpoint (if any) and the batches
+// logged after it. A missing log just yields the checkpointed state.
+StatisticsCalculator* recover_calculator(const char* checkpoint_path, const char* wal_path) {
+    uint64_t checkpoint_lsn = 0;
+    StatisticsCalculator* calc = checkpoint_path != NULL && access(checkpoint_path, F_OK) == 0
+                                     ? load_checkpoint(checkpoint_path, &checkpoint_lsn)
+                                     : create_calculator();
+    if (calc == NULL) {
+        return NULL;
     }
+    int fd = open(wal_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return calc;
+    }
+    if (wal_scan(fd, checkpoint_lsn, calc, NULL) < 0) {
+        printf("Error: Invalid write-ahead log %s\n", wal_path);
+        free_calculator(calc);
+        calc = NULL;
+    }
+    close(fd);
+    return calc;
 }
 
+#ifndef STATS_NO_MAIN
+
 // Example 1: Basic statistics
 void example_1(void) {
     printf("\n========== Example 1: Basic Statistics ==========\n");
@@ -501,8 +3701,341 @@ void example_6(void) {
     free_calculator(calc);
 }
 
+// Benchmark runner used by MultiParadigmBench.py: one tab-separated line per
+// operation with its size, wall time, peak RSS and result.
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Prefer VmHWM: ru_maxrss also counts the parent's footprint inherited at fork
+static long peak_rss_kb(void) {
+    FILE* status = fopen("/proc/self/status", "r");
+    if (status != NULL) {
+        char line[128];
+        long kb = -1;
+        while (fgets(line, sizeof(line), status) != NULL) {
+            if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+                break;
+            }
+        }
+        fclose(status);
+        if (kb >= 0) {
+            return kb;
+        }
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static int* read_dataset(const char* path, int* count) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open dataset %s\n", path);
+        return NULL;
+    }
+    int capacity = 1024;
+    int* values = (int*)malloc((size_t)capacity * sizeof(int));
+    *count = 0;
+    int value;
+    while (values != NULL && fscanf(file, "%d", &value) == 1) {
+        if (*count == capacity) {
+            capacity *= 2;
+            int* grown = (int*)realloc(values, (size_t)capacity * sizeof(int));
+            if (grown == NULL) {
+                free(values);
+                values = NULL;
+                break;
+            }
+            values = grown;
+        }
+        values[(*count)++] = value;
+    }
+    fclose(file);
+    return values;
+}
+
+static int run_benchmark(const char* path) {
+    int n = 0;
+    int* values = read_dataset(path, &n);
+    if (values == NULL) {
+        return 1;
+    }
+    const char* ops[] = {"add_values", "mean", "median", "mode",
+                         "std_dev_sample", "std_dev_population", "range"};
+    int* modes = (int*)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    for (size_t op = 0; op < sizeof(ops) / sizeof(ops[0]); op++) {
+        StatisticsCalculator* calc = create_calculator();
+        double start = now_seconds();
+        add_values(calc, values, n);
+        double elapsed = now_seconds() - start;
+
+        char result[64] = "";
+        int mode_count = 0;
+        if (op > 0) {
+            start = now_seconds();
+            switch (op) {
+                case 1: snprintf(result, sizeof(result), "%.9g", calculate_mean(calc)); break;
+                case 2: snprintf(result, sizeof(result), "%.9g", calculate_median(calc)); break;
+                case 3: calculate_mode(calc, modes, &mode_count); break;
+                case 4: snprintf(result, sizeof(result), "%.9g", calculate_std_dev(calc, 0)); break;
+                case 5: snprintf(result, sizeof(result), "%.9g", calculate_std_dev(calc, 1)); break;
+                case 6: snprintf(result, sizeof(result), "%d", calculate_range(calc)); break;
+            }
+            elapsed = now_seconds() - start;
+        } else {
+            snprintf(result, sizeof(result), "%d", calc->count);
+        }
+
+        printf("%s\t%d\t%.9f\t%ld\t", ops[op], n, elapsed, peak_rss_kb());
+        if (op == 3) {
+            for (int i = 0; i < mode_count; i++) {
+                printf(i > 0 ? ",%d" : "%d", modes[i]);
+            }
+        } else {
+            printf("%s", result);
+        }
+        printf("\n");
+        free_calculator(calc);
+    }
+    free(modes);
+    free(values);
+    return 0;
+}
+
+// Sort benchmark: one tab-separated line per distribution and backend with
+// the best of three wall times. "sort_data" is the full dispatch, including
+// the presorted, counting and run-merging shortcuts.
+static void fill_sort_input(int* values, int n, int distribution, unsigned* seed) {
+    for (int i = 0; i < n; i++) {
+        unsigned r = (unsigned)rand_r(seed) * 2654435761u + (unsigned)rand_r(seed);
+        switch (distribution) {
+            case 0: values[i] = (int)r; break;                            // uniform
+            case 1: values[i] = (int)(r % 101); break;                    // narrow
+            case 2: values[i] = i; break;                                 // sorted
+            case 3: values[i] = n - i; break;                             // reversed
+            case 4: values[i] = r % 100 == 0 ? (int)r : i; break;         // nearly sorted
+            case 5: values[i] = (int)(r % 16) * 1000003; break;           // few unique
+            default: values[i] = (i % 4096) * 524288 + (int)(r % 1024); break;  // sawtooth
+        }
+    }
+}
+
+static int run_sort_benchmark(int n) {
+    const char* distributions[] = {"uniform", "narrow", "sorted", "reversed",
+                                   "nearly_sorted", "few_unique", "sawtooth"};
+    const char* backends[] = {"qsort", "avx2", "avx512", "sort_data"};
+    int* input = (int*)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    int* values = (int*)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    if (input == NULL || values == NULL) {
+        printf("Memory allocation failed\n");
+        free(input);
+        free(values);
+        return 1;
+    }
+    unsigned seed = 42;
+    for (int d = 0; d < 7; d++) {
+        fill_sort_input(input, n, d, &seed);
+        for (int backend = 0; backend < 4; backend++) {
+            if (backend < 3 && !sort_backend_supported(backend)) {
+                continue;
+            }
+            double best = 0.0;
+            for (int round = 0; round < 3; round++) {
+                double elapsed;
+                if (backend == 3) {
+                    StatisticsCalculator* calc = create_calculator();
+                    add_values(calc, input, n);
+                    double start = now_seconds();
+                    sort_data(calc);
+                    elapsed = now_seconds() - start;
+                    free_calculator(calc);
+                } else {
+                    memcpy(values, input, (size_t)n * sizeof(int));
+                    double start = now_seconds();
+                    sort_ints_with(backend, values, n);
+                    elapsed = now_seconds() - start;
+                }
+                best = round == 0 || elapsed < best ? elapsed : best;
+            }
+            printf("%s\t%s\t%d\t%.9f\n", distributions[d], backends[backend], n, best);
+        }
+    }
+    free(input);
+    free(values);
+    return 0;
+}
+
+// Header layout from before the hot fields moved to the front: buffer
+// pointers first, with count, the cached results and cache_flags spread over
+// two cache lines. Only the cached-query benchmark uses it, as a baseline.
+typedef struct {
+    int* data;
+    int count;
+    int capacity;
+    int* sorted_data;
+    int sorted_count;
+    long long cache_sum;
+    float cache_mean;
+    float cache_median;
+    int* cache_mode;
+    int cache_mode_count;
+    float cache_std_dev_sample;
+    float cache_std_dev_population;
+    int cache_range;
+    int cache_min;
+    int cache_max;
+    int* histogram;
+    int histogram_base;
+    int histogram_span;
+    int cache_flags;
+    uint64_t version;
+} LegacyCalculatorLayout;
+
+// The cached path of calculate_*(): check the count and the flag, then load
+#define CACHED_RESULT(calc, flag, field) \
+    ((calc)->count > 0 && ((calc)->cache_flags & (flag)) ? (double)(calc)->field : NAN)
+
+static inline double query_cached(const StatisticsCalculator* calc, int query) {
+    switch (query) {
+        case 0: return CACHED_RESULT(calc, CACHE_MEAN, cache_mean);
+        case 1: return CACHED_RESULT(calc, CACHE_MEDIAN, cache_median);
+        case 2: return CACHED_RESULT(calc, CACHE_RANGE, cache_range);
+        default: return CACHED_RESULT(calc, CACHE_STD_DEV_SAMPLE, cache_std_dev_sample);
+    }
+}
+
+static inline double query_cached_legacy(const LegacyCalculatorLayout* calc, int query) {
+    switch (query) {
+        case 0: return CACHED_RESULT(calc, CACHE_MEAN, cache_mean);
+        case 1: return CACHED_RESULT(calc, CACHE_MEDIAN, cache_median);
+        case 2: return CACHED_RESULT(calc, CACHE_RANGE, cache_range);
+        default: return CACHED_RESULT(calc, CACHE_STD_DEV_SAMPLE, cache_std_dev_sample);
+    }
+}
+
+// Cached-query benchmark: `n` calculators of 8 values with their statistics
+// already cached, queried in shuffled order so each query finds its
+// calculator out of cache. Each query runs against the current header and
+// against a copy of the same results in the legacy layout (with the data
+// buffer it allocated alongside). Prints the best of three nanoseconds per
+// query for each.
+static int run_query_benchmark(int n) {
+    const char* queries[] = {"mean", "median", "range", "std_dev"};
+    StatisticsCalculator** calcs = (StatisticsCalculator**)calloc((size_t)(n > 0 ? n : 1), sizeof(*calcs));
+    LegacyCalculatorLayout** legacy = (LegacyCalculatorLayout**)calloc((size_t)(n > 0 ? n : 1), sizeof(*legacy));
+    int status = 0;
+    if (calcs == NULL || legacy == NULL) {
+        printf("Memory allocation failed\n");
+        status = 1;
+        n = 0;
+    }
+    unsigned seed = 42;
+    for (int i = 0; i < n; i++) {
+        calcs[i] = create_calculator();
+        if (calcs[i] == NULL) {
+            status = 1;
+            n = i;
+            break;
+        }
+        for (int j = 0; j < 8; j++) {
+            add_value(calcs[i], rand_r(&seed) % 1000);
+        }
+        require_statistics(calcs[i], CACHE_MEAN | CACHE_MEDIAN | CACHE_RANGE | CACHE_STD_DEV_SAMPLE);
+    }
+    for (int i = 0; i < n; i++) {
+        legacy[i] = (LegacyCalculatorLayout*)calloc(1, sizeof(LegacyCalculatorLayout));
+        int* data = (int*)malloc(INLINE_VALUES * sizeof(int));
+        if (legacy[i] == NULL || data == NULL) {
+            printf("Memory allocation failed\n");
+            free(data);
+            status = 1;
+            break;
+        }
+        legacy[i]->data = data;
+        memcpy(data, calcs[i]->data, (size_t)calcs[i]->count * sizeof(int));
+        legacy[i]->count = calcs[i]->count;
+        legacy[i]->capacity = INLINE_VALUES;
+        legacy[i]->cache_sum = calcs[i]->cache_sum;
+        legacy[i]->cache_mean = calcs[i]->cache_mean;
+        legacy[i]->cache_median = calcs[i]->cache_median;
+        legacy[i]->cache_std_dev_sample = calcs[i]->cache_std_dev_sample;
+        legacy[i]->cache_std_dev_population = calcs[i]->cache_std_dev_population;
+        legacy[i]->cache_range = calcs[i]->cache_range;
+        legacy[i]->cache_min = calcs[i]->cache_min;
+        legacy[i]->cache_max = calcs[i]->cache_max;
+        legacy[i]->cache_flags = calcs[i]->cache_flags;
+        legacy[i]->version = calcs[i]->version;
+    }
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand_r(&seed) % (i + 1);
+        StatisticsCalculator* swap = calcs[i];
+        calcs[i] = calcs[j];
+        calcs[j] = swap;
+        LegacyCalculatorLayout* swap_legacy = legacy[i];
+        legacy[i] = legacy[j];
+        legacy[j] = swap_legacy;
+    }
+    for (int q = 0; q < 4 && status == 0 && n > 0; q++) {
+        for (int layout = 0; layout < 2; layout++) {
+            double best = 0.0;
+            volatile double sink = 0.0;
+            for (int round = 0; round < 3; round++) {
+                double total = 0.0;
+                double start = now_seconds();
+                if (layout == 0) {
+                    for (int i = 0; i < n; i++) {
+                        total += query_cached_legacy(legacy[i], q);
+                    }
+                } else {
+                    for (int i = 0; i < n; i++) {
+                        total += query_cached(calcs[i], q);
+                    }
+                }
+                double elapsed = now_seconds() - start;
+                sink += total;
+                best = round == 0 || elapsed < best ? elapsed : best;
+            }
+            printf("%s\t%s\t%d\t%.2f\n", queries[q], layout == 0 ? "legacy" : "hot_line", n, best * 1e9 / n);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        free_calculator(calcs[i]);
+        if (legacy[i] != NULL) {
+            free(legacy[i]->data);
+            free(legacy[i]);
+        }
+    }
+    free(calcs);
+    free(legacy);
+    return status;
+}
+
 // Main function
-int main(void) {
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "--bench") == 0) {
+        return run_benchmark(argv[2]);
+    }
+    if (argc == 3 && strcmp(argv[1], "--sort-bench") == 0) {
+        return run_sort_benchmark(atoi(argv[2]));
+    }
+    if (argc == 3 && strcmp(argv[1], "--query-bench") == 0) {
+        return run_query_benchmark(atoi(argv[2]));
+    }
+    if (argc >= 2 && argc <= 3 && strcmp(argv[1], "--tune") == 0) {
+        int status = tune_thresholds(argc == 3 ? argv[2] : NULL, 1);
+        if (status == 2) {
+            printf("Error: Cannot write the tuning file\n");
+        }
+        printf("sort_backend %s\ncounting_sort_percent %d\nrun_merge_max_runs %d\nsmall_network_max %d\n",
+               SORT_BACKEND_NAMES[tuning.sort_backend >= 0 ? tuning.sort_backend : widest_sort_backend()],
+               tuning.counting_sort_percent,
+               tuning.run_merge_max_runs, tuning.small_network_max);
+        return status == 1 ? 0 : 1;
+    }
+
     printf("============================================================\n");
     printf("        Statistics Calculator Demonstration (C Version)\n");
     printf("============================================================\n");
@@ -520,3 +4053,7 @@ int main(void) {
     
     return 0;
 }
+
+#endif /* STATS_NO_MAIN */
+
+#endif /* MULTIPARADIGM_C_INCLUDED */
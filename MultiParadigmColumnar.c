@@ -0,0 +1,1289 @@
+/*
+ * Columnar ingestion for the C StatisticsCalculator.
+ *
+ * Reads integer columns from Apache Arrow IPC files/streams and Parquet files
+ * straight into a calculator, one Arrow record batch or Parquet row group at a
+ * time. Input files are memory-mapped; int32 columns whose layout already
+ * matches the engine (Arrow data buffers, uncompressed PLAIN Parquet pages)
+ * are passed to add_values() in place, one run of valid values at a time.
+ * Other integer widths are converted through a small fixed buffer and must
+ * fit in a C int. Null entries (validity bitmaps / definition levels) are
+ * skipped.
+ *
+ * Supported subset:
+ *   Arrow   - IPC file and stream format, metadata V4/V5, little-endian,
+ *             uncompressed bodies, flat (non-dictionary) Int columns of any
+ *             width; other field types are skipped.
+ *   Parquet - flat schemas, REQUIRED/OPTIONAL INT32/INT64 columns, data page
+ *             v1 and v2, PLAIN and dictionary encodings, UNCOMPRESSED or
+ *             SNAPPY codecs.
+ *
+ * Build:
+ *   gcc -O2 MultiParadigmColumnar.c -o columnar -lm
+ *   ./columnar data.arrow [column]
+ */
+
+#ifndef MULTIPARADIGM_COLUMNAR_INCLUDED
+#define MULTIPARADIGM_COLUMNAR_INCLUDED
+
+#define STATS_NO_MAIN
+#include "MultiParadigmC.c"
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "MultiParadigmColumnar.c reads little-endian buffers in place"
+#endif
+
+#define CONVERT_CHUNK 1024
+#define ADD_VALUES_MAX (1 << 30)   // Largest run handed to add_values() at once
+
+long long ingest_arrow_ipc(StatisticsCalculator* calc, const char* path, const char* column);
+long long ingest_parquet(StatisticsCalculator* calc, const char* path, const char* column);
+long long ingest_columnar_file(StatisticsCalculator* calc, const char* path, const char* column);
+
+/* ------------------------------------------------------------------------ */
+/* Shared helpers                                                           */
+/* ------------------------------------------------------------------------ */
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+} MappedFile;
+
+static int map_file(const char* path, MappedFile* file) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open %s\n", path);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        printf("Error: Cannot read %s\n", path);
+        close(fd);
+        return -1;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error: Cannot map %s\n", path);
+        return -1;
+    }
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    file->data = (const uint8_t*)data;
+    file->size = (size_t)st.st_size;
+    return 0;
+}
+
+static void unmap_file(MappedFile* file) {
+    munmap((void*)file->data, file->size);
+}
+
+static uint16_t load_u16(const uint8_t* p) { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+static uint32_t load_u32(const uint8_t* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+static uint64_t load_u64(const uint8_t* p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+// Hand `count` int32 values to the engine, splitting runs that exceed an int
+static void add_int32_run(StatisticsCalculator* calc, const uint8_t* values, long long count) {
+    if (((uintptr_t)values & (sizeof(int) - 1)) == 0) {
+        while (count > 0) {
+            int n = count > ADD_VALUES_MAX ? ADD_VALUES_MAX : (int)count;
+            add_values(calc, (const int*)values, n);
+            values += (size_t)n * sizeof(int);
+            count -= n;
+        }
+        return;
+    }
+    int chunk[CONVERT_CHUNK];  // Unaligned page data: copy through a buffer instead
+    while (count > 0) {
+        int n = count > CONVERT_CHUNK ? CONVERT_CHUNK : (int)count;
+        memcpy(chunk, values, (size_t)n * sizeof(int));
+        add_values(calc, chunk, n);
+        values += (size_t)n * sizeof(int);
+        count -= n;
+    }
+}
+
+// Read element `i` of a little-endian integer array as a 64-bit value
+static int read_int_element(const uint8_t* values, long long i, int width, int is_signed,
+                            long long* out) {
+    const uint8_t* p = values + i * width;
+    switch (width) {
+        case 1: *out = is_signed ? (long long)(int8_t)p[0] : (long long)p[0]; return 0;
+        case 2: *out = is_signed ? (long long)(int16_t)load_u16(p) : (long long)load_u16(p); return 0;
+        case 4: *out = is_signed ? (long long)(int32_t)load_u32(p) : (long long)load_u32(p); return 0;
+        default: {
+            uint64_t u = load_u64(p);
+            if (!is_signed && u > (uint64_t)LLONG_MAX) {
+                return -1;
+            }
+            *out = (long long)u;
+            return 0;
+        }
+    }
+}
+
+// Convert `count` integers of any width into the engine; -1 if one overflows int
+static int add_converted_run(StatisticsCalculator* calc, const uint8_t* values, long long count,
+                             int width, int is_signed) {
+    if (width == 4 && is_signed) {
+        add_int32_run(calc, values, count);
+        return 0;
+    }
+    int chunk[CONVERT_CHUNK];
+    long long i = 0;
+    while (i < count) {
+        int filled = 0;
+        for (; i < count && filled < CONVERT_CHUNK; i++) {
+            long long value;
+            if (read_int_element(values, i, width, is_signed, &value) != 0 ||
+                value < INT_MIN || value > INT_MAX) {
+                printf("Error: Column value does not fit in a C int\n");
+                return -1;
+            }
+            chunk[filled++] = (int)value;
+        }
+        add_values(calc, chunk, filled);
+    }
+    return 0;
+}
+
+// Position of the first bit equal to `want` in [pos, length), or `length`
+static long long next_bit(const uint8_t* bitmap, long long pos, long long length, int want) {
+    while (pos < length) {
+        if ((pos & 63) == 0 && pos + 64 <= length) {
+            uint64_t word = load_u64(bitmap + pos / 8);
+            if (!want) {
+                word = ~word;
+            }
+            if (word == 0) {
+                pos += 64;
+                continue;
+            }
+            return pos + __builtin_ctzll(word);
+        }
+        if (((bitmap[pos >> 3] >> (pos & 7)) & 1) == want) {
+            return pos;
+        }
+        pos++;
+    }
+    return length;
+}
+
+/* ------------------------------------------------------------------------ */
+/* Arrow IPC                                                                */
+/* ------------------------------------------------------------------------ */
+
+// Bounds-checked reader over one flatbuffer; any out-of-range access sets `bad`
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    int bad;
+} FlatBuffer;
+
+static int fb_in_bounds(FlatBuffer* fb, size_t pos, size_t len) {
+    if (pos > fb->size || len > fb->size - pos) {
+        fb->bad = 1;
+        return 0;
+    }
+    return 1;
+}
+
+// Absolute position of field `index` of the table at `table`, or 0 if absent
+static size_t fb_field(FlatBuffer* fb, size_t table, int index) {
+    if (table == 0 || !fb_in_bounds(fb, table, 4)) {
+        return 0;
+    }
+    int32_t soffset = (int32_t)load_u32(fb->data + table);
+    long long vtable = (long long)table - soffset;
+    if (vtable < 0 || !fb_in_bounds(fb, (size_t)vtable, 4)) {
+        fb->bad = 1;
+        return 0;
+    }
+    uint16_t vtable_size = load_u16(fb->data + vtable);
+    size_t entry = (size_t)(4 + 2 * index);
+    if (entry + 2 > vtable_size || !fb_in_bounds(fb, (size_t)vtable + entry, 2)) {
+        return 0;
+    }
+    uint16_t offset = load_u16(fb->data + vtable + entry);
+    return offset == 0 ? 0 : table + offset;
+}
+
+static long long fb_int(FlatBuffer* fb, size_t table, int index, int width, long long fallback) {
+    size_t pos = fb_field(fb, table, index);
+    if (pos == 0 || !fb_in_bounds(fb, pos, (size_t)width)) {
+        return fallback;
+    }
+    switch (width) {
+        case 1: return fb->data[pos];
+        case 2: return (int16_t)load_u16(fb->data + pos);
+        case 4: return (int32_t)load_u32(fb->data + pos);
+        default: return (long long)load_u64(fb->data + pos);
+    }
+}
+
+// Follow the offset stored at `pos`; returns 0 when absent or out of range
+static size_t fb_deref(FlatBuffer* fb, size_t pos) {
+    if (pos == 0 || !fb_in_bounds(fb, pos, 4)) {
+        return 0;
+    }
+    size_t target = pos + load_u32(fb->data + pos);
+    return fb_in_bounds(fb, target, 4) ? target : 0;
+}
+
+// Root table of the buffer (the offset stored at position 0)
+static size_t fb_root(FlatBuffer* fb) {
+    if (!fb_in_bounds(fb, 0, 4)) {
+        return 0;
+    }
+    size_t root = load_u32(fb->data);
+    return root != 0 && fb_in_bounds(fb, root, 4) ? root : 0;
+}
+
+static size_t fb_table(FlatBuffer* fb, size_t table, int index) {
+    return fb_deref(fb, fb_field(fb, table, index));
+}
+
+// Vector field: returns the position of element 0 and its length via `length`
+static size_t fb_vector(FlatBuffer* fb, size_t table, int index, size_t elem_size,
+                        uint32_t* length) {
+    size_t vec = fb_table(fb, table, index);
+    *length = 0;
+    if (vec == 0) {
+        return 0;
+    }
+    uint32_t n = load_u32(fb->data + vec);
+    if (!fb_in_bounds(fb, vec + 4, (size_t)n * elem_size)) {
+        return 0;
+    }
+    *length = n;
+    return vec + 4;
+}
+
+static int fb_string_equals(FlatBuffer* fb, size_t table, int index, const char* expected) {
+    size_t str = fb_table(fb, table, index);
+    if (str == 0) {
+        return 0;
+    }
+    uint32_t len = load_u32(fb->data + str);
+    return fb_in_bounds(fb, str + 4, len) && len == strlen(expected) &&
+           memcmp(fb->data + str + 4, expected, len) == 0;
+}
+
+// Arrow flatbuffer schema constants (Schema.fbs / Message.fbs)
+enum { ARROW_HEADER_SCHEMA = 1, ARROW_HEADER_DICTIONARY_BATCH = 2, ARROW_HEADER_RECORD_BATCH = 3 };
+enum { ARROW_MESSAGE_VERSION = 0, ARROW_MESSAGE_HEADER_TYPE = 1, ARROW_MESSAGE_HEADER = 2,
+       ARROW_MESSAGE_BODY_LENGTH = 3 };
+enum { ARROW_SCHEMA_ENDIANNESS = 0, ARROW_SCHEMA_FIELDS = 1 };
+enum { ARROW_FIELD_NAME = 0, ARROW_FIELD_TYPE_TYPE = 2, ARROW_FIELD_TYPE = 3,
+       ARROW_FIELD_DICTIONARY = 4, ARROW_FIELD_CHILDREN = 5 };
+enum { ARROW_BATCH_LENGTH = 0, ARROW_BATCH_NODES = 1, ARROW_BATCH_BUFFERS = 2,
+       ARROW_BATCH_COMPRESSION = 3 };
+enum { ARROW_TYPE_NULL = 1, ARROW_TYPE_INT = 2, ARROW_TYPE_BINARY = 4, ARROW_TYPE_UTF8 = 5,
+       ARROW_TYPE_LIST = 12, ARROW_TYPE_STRUCT = 13, ARROW_TYPE_UNION = 14,
+       ARROW_TYPE_FIXED_SIZE_LIST = 16, ARROW_TYPE_MAP = 17, ARROW_TYPE_LARGE_BINARY = 19,
+       ARROW_TYPE_LARGE_UTF8 = 20, ARROW_TYPE_LARGE_LIST = 21, ARROW_TYPE_RUN_END_ENCODED = 22,
+       ARROW_TYPE_BINARY_VIEW = 23, ARROW_TYPE_UTF8_VIEW = 24, ARROW_TYPE_LIST_VIEW = 25,
+       ARROW_TYPE_LARGE_LIST_VIEW = 26 };
+#define ARROW_METADATA_V4 3
+#define ARROW_CONTINUATION 0xFFFFFFFFu
+
+typedef struct {
+    int found;
+    int node_index;     // Index of the column's FieldNode in each record batch
+    int buffer_index;   // Index of its validity buffer; data follows
+    int width;          // Bytes per value
+    int is_signed;
+} ArrowColumn;
+
+// Count the field nodes and buffers a field (and its children) occupies in a batch
+static int arrow_field_layout(FlatBuffer* fb, size_t field, int depth, int* nodes, int* buffers) {
+    if (depth > 64) {
+        return -1;
+    }
+    int type = (int)fb_int(fb, field, ARROW_FIELD_TYPE_TYPE, 1, 0);
+    switch (type) {
+        case ARROW_TYPE_NULL:
+        case ARROW_TYPE_RUN_END_ENCODED:
+            break;
+        case ARROW_TYPE_STRUCT:
+        case ARROW_TYPE_FIXED_SIZE_LIST:
+            *buffers += 1;
+            break;
+        case ARROW_TYPE_BINARY:
+        case ARROW_TYPE_UTF8:
+        case ARROW_TYPE_LARGE_BINARY:
+        case ARROW_TYPE_LARGE_UTF8:
+        case ARROW_TYPE_LIST_VIEW:
+        case ARROW_TYPE_LARGE_LIST_VIEW:
+            *buffers += 3;
+            break;
+        case ARROW_TYPE_UNION:
+        case ARROW_TYPE_BINARY_VIEW:
+        case ARROW_TYPE_UTF8_VIEW:
+            printf("Error: Arrow union and view columns are not supported\n");
+            return -1;
+        default:
+            // Fixed-width primitives, List, LargeList and Map: validity + one buffer
+            *buffers += 2;
+            break;
+    }
+    *nodes += 1;
+    uint32_t child_count;
+    size_t children = fb_vector(fb, field, ARROW_FIELD_CHILDREN, 4, &child_count);
+    for (uint32_t i = 0; i < child_count; i++) {
+        size_t child = fb_deref(fb, children + 4 * i);
+        if (arrow_field_layout(fb, child, depth + 1, nodes, buffers) != 0) {
+            return -1;
+        }
+    }
+    return fb->bad ? -1 : 0;
+}
+
+static int arrow_find_column(FlatBuffer* fb, size_t schema, const char* column, ArrowColumn* out) {
+    if (fb_int(fb, schema, ARROW_SCHEMA_ENDIANNESS, 2, 0) != 0) {
+        printf("Error: Big-endian Arrow data is not supported\n");
+        return -1;
+    }
+    uint32_t field_count;
+    size_t fields = fb_vector(fb, schema, ARROW_SCHEMA_FIELDS, 4, &field_count);
+    int nodes = 0;
+    int buffers = 0;
+    out->found = 0;
+    for (uint32_t i = 0; i < field_count && !out->found; i++) {
+        size_t field = fb_deref(fb, fields + 4 * i);
+        int type = (int)fb_int(fb, field, ARROW_FIELD_TYPE_TYPE, 1, 0);
+        int matches = column != NULL ? fb_string_equals(fb, field, ARROW_FIELD_NAME, column)
+                                     : type == ARROW_TYPE_INT;
+        if (matches) {
+            if (type != ARROW_TYPE_INT || fb_field(fb, field, ARROW_FIELD_DICTIONARY) != 0) {
+                printf("Error: Column %s is not a plain Arrow integer column\n",
+                       column != NULL ? column : "(first integer)");
+                return -1;
+            }
+            size_t int_type = fb_table(fb, field, ARROW_FIELD_TYPE);
+            int bits = (int)fb_int(fb, int_type, 0, 4, 0);
+            if (bits != 8 && bits != 16 && bits != 32 && bits != 64) {
+                printf("Error: Unsupported Arrow integer width %d\n", bits);
+                return -1;
+            }
+            out->found = 1;
+            out->node_index = nodes;
+            out->buffer_index = buffers;
+            out->width = bits / 8;
+            out->is_signed = (int)fb_int(fb, int_type, 1, 1, 0);
+        }
+        if (arrow_field_layout(fb, field, 0, &nodes, &buffers) != 0) {
+            return -1;
+        }
+    }
+    if (fb->bad) {
+        printf("Error: Malformed Arrow schema\n");
+        return -1;
+    }
+    if (!out->found) {
+        printf("Error: No integer column%s%s in Arrow schema\n",
+               column != NULL ? " named " : "", column != NULL ? column : "");
+        return -1;
+    }
+    return 0;
+}
+
+static long long arrow_ingest_batch(StatisticsCalculator* calc, FlatBuffer* fb, size_t batch,
+                                    const ArrowColumn* col, const uint8_t* body,
+                                    size_t body_length) {
+    if (fb_field(fb, batch, ARROW_BATCH_COMPRESSION) != 0) {
+        printf("Error: Compressed Arrow record batches are not supported\n");
+        return -1;
+    }
+    uint32_t node_count;
+    uint32_t buffer_count;
+    size_t nodes = fb_vector(fb, batch, ARROW_BATCH_NODES, 16, &node_count);
+    size_t buffers = fb_vector(fb, batch, ARROW_BATCH_BUFFERS, 16, &buffer_count);
+    if (fb->bad || (uint32_t)col->node_index >= node_count ||
+        (uint32_t)col->buffer_index + 1 >= buffer_count) {
+        printf("Error: Malformed Arrow record batch\n");
+        return -1;
+    }
+    const uint8_t* node = fb->data + nodes + 16 * (size_t)col->node_index;
+    long long length = (long long)load_u64(node);
+    long long null_count = (long long)load_u64(node + 8);
+    const uint8_t* validity_desc = fb->data + buffers + 16 * (size_t)col->buffer_index;
+    const uint8_t* data_desc = validity_desc + 16;
+    uint64_t validity_offset = load_u64(validity_desc);
+    uint64_t validity_length = load_u64(validity_desc + 8);
+    uint64_t data_offset = load_u64(data_desc);
+    uint64_t data_length = load_u64(data_desc + 8);
+
+    if (length < 0 || data_offset > body_length || data_length > body_length - data_offset ||
+        (uint64_t)length * (uint64_t)col->width > data_length ||
+        validity_offset > body_length || validity_length > body_length - validity_offset ||
+        (null_count > 0 && validity_length * 8 < (uint64_t)length)) {
+        printf("Error: Arrow buffer out of range\n");
+        return -1;
+    }
+    const uint8_t* values = body + data_offset;
+    if (null_count == 0 || validity_length == 0) {
+        return add_converted_run(calc, values, length, col->width, col->is_signed) == 0 ? length : -1;
+    }
+
+    // Walk runs of set validity bits; each run is ingested in place
+    const uint8_t* validity = body + validity_offset;
+    long long added = 0;
+    long long pos = 0;
+    while (pos < length) {
+        long long start = next_bit(validity, pos, length, 1);
+        long long end = next_bit(validity, start, length, 0);
+        if (end > start) {
+            if (add_converted_run(calc, values + start * col->width, end - start,
+                                  col->width, col->is_signed) != 0) {
+                return -1;
+            }
+            added += end - start;
+        }
+        pos = end;
+    }
+    return added;
+}
+
+long long ingest_arrow_ipc(StatisticsCalculator* calc, const char* path, const char* column) {
+    MappedFile file;
+    if (map_file(path, &file) != 0) {
+        return -1;
+    }
+    size_t pos = 0;
+    size_t end = file.size;
+    if (file.size >= 8 && memcmp(file.data, "ARROW1", 6) == 0) {
+        // File format: stream messages sit between the magic and the footer
+        if (file.size < 18 || memcmp(file.data + file.size - 6, "ARROW1", 6) != 0) {
+            printf("Error: Truncated Arrow file %s\n", path);
+            unmap_file(&file);
+            return -1;
+        }
+        uint32_t footer_length = load_u32(file.data + file.size - 10);
+        pos = 8;
+        end = footer_length <= file.size - 18 ? file.size - 10 - footer_length : 8;
+    }
+
+    ArrowColumn col = {0, 0, 0, 0, 0};
+    long long added = 0;
+    int have_schema = 0;
+    while (pos + 8 <= end) {
+        uint32_t metadata_length = load_u32(file.data + pos);
+        pos += 4;
+        if (metadata_length == ARROW_CONTINUATION) {
+            metadata_length = load_u32(file.data + pos);
+            pos += 4;
+        }
+        if (metadata_length == 0) {
+            break;  // End-of-stream marker
+        }
+        if (metadata_length > end - pos) {
+            printf("Error: Truncated Arrow message in %s\n", path);
+            added = -1;
+            break;
+        }
+        FlatBuffer fb = {file.data + pos, metadata_length, 0};
+        size_t message = fb_root(&fb);
+        long long version = fb_int(&fb, message, ARROW_MESSAGE_VERSION, 2, 0);
+        int header_type = (int)fb_int(&fb, message, ARROW_MESSAGE_HEADER_TYPE, 1, 0);
+        size_t header = fb_table(&fb, message, ARROW_MESSAGE_HEADER);
+        long long body_length = fb_int(&fb, message, ARROW_MESSAGE_BODY_LENGTH, 8, 0);
+        const uint8_t* body = file.data + pos + metadata_length;
+        size_t body_available = end - pos - metadata_length;
+        if (fb.bad || message == 0 || version < ARROW_METADATA_V4 || body_length < 0 ||
+            (unsigned long long)body_length > body_available) {
+            printf("Error: Malformed Arrow message in %s\n", path);
+            added = -1;
+            break;
+        }
+
+        if (header_type == ARROW_HEADER_SCHEMA) {
+            if (arrow_find_column(&fb, header, column, &col) != 0) {
+                added = -1;
+                break;
+            }
+            have_schema = 1;
+        } else if (header_type == ARROW_HEADER_RECORD_BATCH) {
+            if (!have_schema) {
+                printf("Error: Arrow record batch before schema in %s\n", path);
+                added = -1;
+                break;
+            }
+            long long n = arrow_ingest_batch(calc, &fb, header, &col, body, (size_t)body_length);
+            if (n < 0) {
+                added = -1;
+                break;
+            }
+            added += n;
+        }
+        pos += metadata_length + (size_t)body_length;
+    }
+    unmap_file(&file);
+    return added;
+}
+
+/* ------------------------------------------------------------------------ */
+/* Parquet                                                                  */
+/* ------------------------------------------------------------------------ */
+
+// Thrift compact protocol reader; any malformed input sets `bad`
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    int bad;
+} ThriftReader;
+
+enum { TT_STOP = 0, TT_TRUE = 1, TT_FALSE = 2, TT_BYTE = 3, TT_I16 = 4, TT_I32 = 5, TT_I64 = 6,
+       TT_DOUBLE = 7, TT_BINARY = 8, TT_LIST = 9, TT_SET = 10, TT_MAP = 11, TT_STRUCT = 12 };
+
+static uint64_t tr_varint(ThriftReader* r) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (r->p >= r->end) {
+            r->bad = 1;
+            return 0;
+        }
+        uint8_t byte = *r->p++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    r->bad = 1;
+    return 0;
+}
+
+static long long tr_int(ThriftReader* r) {
+    uint64_t v = tr_varint(r);
+    return (long long)(v >> 1) ^ -(long long)(v & 1);
+}
+
+static void tr_advance(ThriftReader* r, uint64_t n) {
+    if (n > (uint64_t)(r->end - r->p)) {
+        r->bad = 1;
+        r->p = r->end;
+        return;
+    }
+    r->p += n;
+}
+
+// Next field header of a struct: returns its type (TT_STOP at the end)
+static int tr_field(ThriftReader* r, int* field_id) {
+    if (r->p >= r->end) {
+        r->bad = 1;
+        return TT_STOP;
+    }
+    uint8_t byte = *r->p++;
+    int type = byte & 0x0f;
+    if (type == TT_STOP) {
+        return TT_STOP;
+    }
+    int delta = byte >> 4;
+    *field_id = delta != 0 ? *field_id + delta : (int)tr_int(r);
+    return type;
+}
+
+static uint32_t tr_list(ThriftReader* r, int* elem_type) {
+    if (r->p >= r->end) {
+        r->bad = 1;
+        return 0;
+    }
+    uint8_t byte = *r->p++;
+    *elem_type = byte & 0x0f;
+    uint32_t size = byte >> 4;
+    return size == 15 ? (uint32_t)tr_varint(r) : size;
+}
+
+static void tr_skip(ThriftReader* r, int type, int depth);
+
+static void tr_skip_struct(ThriftReader* r, int depth) {
+    int id = 0;
+    int type;
+    while (!r->bad && (type = tr_field(r, &id)) != TT_STOP) {
+        tr_skip(r, type, depth + 1);
+    }
+}
+
+static void tr_skip(ThriftReader* r, int type, int depth) {
+    if (depth > 32) {
+        r->bad = 1;
+        return;
+    }
+    switch (type) {
+        case TT_TRUE:
+        case TT_FALSE:
+            break;  // Struct booleans live in the field header
+        case TT_BYTE: tr_advance(r, 1); break;
+        case TT_I16:
+        case TT_I32:
+        case TT_I64: tr_varint(r); break;
+        case TT_DOUBLE: tr_advance(r, 8); break;
+        case TT_BINARY: tr_advance(r, tr_varint(r)); break;
+        case TT_LIST:
+        case TT_SET: {
+            int elem;
+            uint32_t n = tr_list(r, &elem);
+            for (uint32_t i = 0; i < n && !r->bad; i++) {
+                if (elem == TT_TRUE || elem == TT_FALSE) {
+                    tr_advance(r, 1);  // Collection booleans are one byte each
+                } else {
+                    tr_skip(r, elem, depth + 1);
+                }
+            }
+            break;
+        }
+        case TT_MAP: {
+            uint64_t n = tr_varint(r);
+            if (n == 0) {
+                break;
+            }
+            if (r->p >= r->end) {
+                r->bad = 1;
+                break;
+            }
+            uint8_t types = *r->p++;
+            for (uint64_t i = 0; i < n && !r->bad; i++) {
+                tr_skip(r, types >> 4, depth + 1);
+                tr_skip(r, types & 0x0f, depth + 1);
+            }
+            break;
+        }
+        case TT_STRUCT: tr_skip_struct(r, depth); break;
+        default: r->bad = 1; break;
+    }
+}
+
+// Parquet enums (parquet.thrift)
+enum { PQ_INT32 = 1, PQ_INT64 = 2 };
+enum { PQ_REQUIRED = 0, PQ_OPTIONAL = 1, PQ_REPEATED = 2 };
+enum { PQ_UINT_32 = 13, PQ_UINT_64 = 14 };
+enum { PQ_UNCOMPRESSED = 0, PQ_SNAPPY = 1 };
+enum { PQ_DATA_PAGE = 0, PQ_DICTIONARY_PAGE = 2, PQ_DATA_PAGE_V2 = 3 };
+enum { PQ_PLAIN = 0, PQ_PLAIN_DICTIONARY = 2, PQ_RLE_DICTIONARY = 8 };
+
+typedef struct {
+    int leaf_index;
+    int physical_type;
+    int is_signed;
+    int max_definition_level;
+} ParquetColumn;
+
+typedef struct {
+    int codec;
+    long long num_values;
+    long long data_page_offset;
+    long long dictionary_page_offset;
+    long long total_compressed_size;
+} ParquetChunk;
+
+typedef struct {
+    int type;
+    int compressed_size;
+    int uncompressed_size;
+    long long num_values;
+    long long num_nulls;        // -1 when the page header does not say
+    int encoding;
+    int definition_levels_length;
+    int repetition_levels_length;
+    int is_compressed;
+} ParquetPage;
+
+#define PARQUET_MAX_DEPTH 32
+
+// Parse the schema list; picks the top-level leaf named `column` or the first int leaf
+static int parquet_read_schema(ThriftReader* r, const char* column, ParquetColumn* out) {
+    int elem;
+    uint32_t count = tr_list(r, &elem);
+    int remaining[PARQUET_MAX_DEPTH] = {0};
+    int depth = 0;
+    int leaves = 0;
+    out->leaf_index = -1;
+    for (uint32_t i = 0; i < count && !r->bad; i++) {
+        int id = 0;
+        int type;
+        int physical = -1;
+        int repetition = PQ_REQUIRED;
+        int num_children = 0;
+        int converted = -1;
+        int name_matches = 0;
+        while ((type = tr_field(r, &id)) != TT_STOP && !r->bad) {
+            if (id == 1 && type == TT_I32) {
+                physical = (int)tr_int(r);
+            } else if (id == 3 && type == TT_I32) {
+                repetition = (int)tr_int(r);
+            } else if (id == 4 && type == TT_BINARY) {
+                uint64_t len = tr_varint(r);
+                const uint8_t* name = r->p;
+                tr_advance(r, len);
+                name_matches = column != NULL && !r->bad && len == strlen(column) &&
+                               memcmp(name, column, len) == 0;
+            } else if (id == 5 && type == TT_I32) {
+                num_children = (int)tr_int(r);
+            } else if (id == 6 && type == TT_I32) {
+                converted = (int)tr_int(r);
+            } else {
+                tr_skip(r, type, 0);
+            }
+        }
+        if (i == 0) {
+            remaining[0] = num_children;  // Root group
+            continue;
+        }
+        // Track the depth-first position: only top-level leaves are ingestible
+        while (depth > 0 && remaining[depth] == 0) {
+            depth--;
+        }
+        remaining[depth]--;
+        int top_level = depth == 0;
+        if (num_children > 0) {
+            if (depth + 1 >= PARQUET_MAX_DEPTH) {
+                printf("Error: Parquet schema nests too deeply\n");
+                return -1;
+            }
+            remaining[++depth] = num_children;
+            continue;
+        }
+        leaves++;
+        int is_int = physical == PQ_INT32 || physical == PQ_INT64;
+        if (out->leaf_index < 0 && top_level && (column != NULL ? name_matches : is_int)) {
+            if (!is_int || repetition == PQ_REPEATED) {
+                printf("Error: Column %s is not a flat INT32/INT64 Parquet column\n",
+                       column != NULL ? column : "(first integer)");
+                return -1;
+            }
+            out->leaf_index = leaves - 1;
+            out->physical_type = physical;
+            out->is_signed = converted != PQ_UINT_32 && converted != PQ_UINT_64;
+            out->max_definition_level = repetition == PQ_OPTIONAL ? 1 : 0;
+        }
+    }
+    if (r->bad) {
+        printf("Error: Malformed Parquet schema\n");
+        return -1;
+    }
+    if (out->leaf_index < 0) {
+        printf("Error: No integer column%s%s in Parquet schema\n",
+               column != NULL ? " named " : "", column != NULL ? column : "");
+        return -1;
+    }
+    return 0;
+}
+
+static void parquet_read_column_meta(ThriftReader* r, ParquetChunk* chunk) {
+    int id = 0;
+    int type;
+    while ((type = tr_field(r, &id)) != TT_STOP && !r->bad) {
+        if (id == 4 && type == TT_I32) {
+            chunk->codec = (int)tr_int(r);
+        } else if (id == 5 && type == TT_I64) {
+            chunk->num_values = tr_int(r);
+        } else if (id == 7 && type == TT_I64) {
+            chunk->total_compressed_size = tr_int(r);
+        } else if (id == 9 && type == TT_I64) {
+            chunk->data_page_offset = tr_int(r);
+        } else if (id == 11 && type == TT_I64) {
+            chunk->dictionary_page_offset = tr_int(r);
+        } else {
+            tr_skip(r, type, 0);
+        }
+    }
+}
+
+static void parquet_read_page_header(ThriftReader* r, ParquetPage* page) {
+    int id = 0;
+    int type;
+    memset(page, 0, sizeof(*page));
+    page->num_nulls = -1;
+    page->is_compressed = 1;
+    while ((type = tr_field(r, &id)) != TT_STOP && !r->bad) {
+        if (id == 1 && type == TT_I32) {
+            page->type = (int)tr_int(r);
+        } else if (id == 2 && type == TT_I32) {
+            page->uncompressed_size = (int)tr_int(r);
+        } else if (id == 3 && type == TT_I32) {
+            page->compressed_size = (int)tr_int(r);
+        } else if ((id == 5 || id == 7 || id == 8) && type == TT_STRUCT) {
+            // DataPageHeader, DictionaryPageHeader and DataPageHeaderV2
+            int sub_id = 0;
+            int sub_type;
+            while ((sub_type = tr_field(r, &sub_id)) != TT_STOP && !r->bad) {
+                if (sub_id == 1 && sub_type == TT_I32) {
+                    page->num_values = tr_int(r);
+                } else if (id == 8 && sub_id == 2 && sub_type == TT_I32) {
+                    page->num_nulls = tr_int(r);
+                } else if (((id != 8 && sub_id == 2) || (id == 8 && sub_id == 4)) &&
+                           sub_type == TT_I32) {
+                    page->encoding = (int)tr_int(r);
+                } else if (id == 8 && sub_id == 5 && sub_type == TT_I32) {
+                    page->definition_levels_length = (int)tr_int(r);
+                } else if (id == 8 && sub_id == 6 && sub_type == TT_I32) {
+                    page->repetition_levels_length = (int)tr_int(r);
+                } else if (id == 8 && sub_id == 7 && (sub_type == TT_TRUE || sub_type == TT_FALSE)) {
+                    page->is_compressed = sub_type == TT_TRUE;
+                } else {
+                    tr_skip(r, sub_type, 1);
+                }
+            }
+        } else {
+            tr_skip(r, type, 0);
+        }
+    }
+}
+
+// Raw Snappy block decompression into `out` (exactly `out_size` bytes)
+static int snappy_decompress(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_size) {
+    ThriftReader r = {in, in + in_size, 0};
+    uint64_t expected = tr_varint(&r);  // Snappy shares the varint encoding
+    if (r.bad || expected != out_size) {
+        return -1;
+    }
+    const uint8_t* p = r.p;
+    const uint8_t* end = in + in_size;
+    size_t op = 0;
+    while (p < end) {
+        uint8_t tag = *p++;
+        size_t length;
+        size_t offset;
+        if ((tag & 3) == 0) {
+            length = (size_t)(tag >> 2) + 1;
+            if (length > 60) {
+                size_t bytes = length - 60;
+                if ((size_t)(end - p) < bytes) {
+                    return -1;
+                }
+                length = 0;
+                for (size_t i = 0; i < bytes; i++) {
+                    length |= (size_t)p[i] << (8 * i);
+                }
+                length += 1;
+                p += bytes;
+            }
+            if ((size_t)(end - p) < length || out_size - op < length) {
+                return -1;
+            }
+            memcpy(out + op, p, length);
+            p += length;
+            op += length;
+            continue;
+        }
+        if ((tag & 3) == 1) {
+            if (p >= end) {
+                return -1;
+            }
+            length = ((tag >> 2) & 7) + 4;
+            offset = ((size_t)(tag >> 5) << 8) | *p++;
+        } else if ((tag & 3) == 2) {
+            if (end - p < 2) {
+                return -1;
+            }
+            length = (size_t)(tag >> 2) + 1;
+            offset = load_u16(p);
+            p += 2;
+        } else {
+            if (end - p < 4) {
+                return -1;
+            }
+            length = (size_t)(tag >> 2) + 1;
+            offset = load_u32(p);
+            p += 4;
+        }
+        if (offset == 0 || offset > op || out_size - op < length) {
+            return -1;
+        }
+        for (size_t i = 0; i < length; i++, op++) {
+            out[op] = out[op - offset];  // Copies may overlap their own output
+        }
+    }
+    return op == out_size ? 0 : -1;
+}
+
+// RLE/bit-packed hybrid decoder; writes `n` values or returns -1
+static int rle_decode(const uint8_t* p, const uint8_t* end, int bit_width, uint32_t* out, long long n) {
+    ThriftReader r = {p, end, 0};
+    long long produced = 0;
+    int byte_width = (bit_width + 7) / 8;
+    while (produced < n) {
+        uint64_t header = tr_varint(&r);
+        if (r.bad) {
+            return -1;
+        }
+        if (header & 1) {
+            long long count = (long long)(header >> 1) * 8;
+            uint64_t bytes = (header >> 1) * (uint64_t)bit_width;
+            if (bytes > (uint64_t)(r.end - r.p)) {
+                return -1;
+            }
+            uint64_t bit = 0;
+            for (long long i = 0; i < count && produced < n; i++, produced++) {
+                uint32_t value = 0;
+                for (int b = 0; b < bit_width; b++, bit++) {
+                    value |= (uint32_t)((r.p[bit >> 3] >> (bit & 7)) & 1) << b;
+                }
+                out[produced] = value;
+            }
+            r.p += bytes;
+        } else {
+            long long count = (long long)(header >> 1);
+            if (r.end - r.p < byte_width) {
+                return -1;
+            }
+            uint32_t value = 0;
+            for (int b = 0; b < byte_width; b++) {
+                value |= (uint32_t)r.p[b] << (8 * b);
+            }
+            r.p += byte_width;
+            for (long long i = 0; i < count && produced < n; i++) {
+                out[produced++] = value;
+            }
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    StatisticsCalculator* calc;
+    const ParquetColumn* column;
+    long long* dictionary;
+    long long dictionary_size;
+    uint8_t* scratch;           // Decompression buffer, reused across pages
+    size_t scratch_size;
+    uint32_t* levels;           // Decoded levels / dictionary indices
+    long long levels_size;
+} ParquetState;
+
+static uint32_t* parquet_levels(ParquetState* st, long long n) {
+    if (n > st->levels_size) {
+        uint32_t* levels = (uint32_t*)realloc(st->levels, (size_t)n * sizeof(uint32_t));
+        if (levels == NULL) {
+            return NULL;
+        }
+        st->levels = levels;
+        st->levels_size = n;
+    }
+    return st->levels;
+}
+
+// Decompress `in` unless the codec is UNCOMPRESSED; returns the usable bytes
+static const uint8_t* parquet_decompress(ParquetState* st, int codec, const uint8_t* in,
+                                         size_t in_size, size_t out_size) {
+    if (codec == PQ_UNCOMPRESSED) {
+        return in_size == out_size ? in : NULL;
+    }
+    if (out_size > st->scratch_size) {
+        uint8_t* scratch = (uint8_t*)realloc(st->scratch, out_size);
+        if (scratch == NULL) {
+            return NULL;
+        }
+        st->scratch = scratch;
+        st->scratch_size = out_size;
+    }
+    return snappy_decompress(in, in_size, st->scratch, out_size) == 0 ? st->scratch : NULL;
+}
+
+static int parquet_add_values(ParquetState* st, const uint8_t* values, const uint8_t* end,
+                              int encoding, long long count) {
+    const ParquetColumn* col = st->column;
+    int width = col->physical_type == PQ_INT32 ? 4 : 8;
+    if (encoding == PQ_PLAIN) {
+        if ((unsigned long long)(end - values) < (unsigned long long)count * width) {
+            return -1;
+        }
+        return add_converted_run(st->calc, values, count, width, col->is_signed);
+    }
+    if (encoding != PQ_PLAIN_DICTIONARY && encoding != PQ_RLE_DICTIONARY) {
+        printf("Error: Unsupported Parquet encoding %d\n", encoding);
+        return -1;
+    }
+    if (values >= end || st->dictionary == NULL) {
+        return -1;
+    }
+    int bit_width = *values++;
+    uint32_t* indices = parquet_levels(st, count);
+    if (bit_width > 32 || indices == NULL || rle_decode(values, end, bit_width, indices, count) != 0) {
+        return -1;
+    }
+    int chunk[CONVERT_CHUNK];
+    long long i = 0;
+    while (i < count) {
+        int filled = 0;
+        for (; i < count && filled < CONVERT_CHUNK; i++) {
+            if (indices[i] >= st->dictionary_size) {
+                return -1;
+            }
+            long long value = st->dictionary[indices[i]];
+            if (value < INT_MIN || value > INT_MAX) {
+                printf("Error: Column value does not fit in a C int\n");
+                return -1;
+            }
+            chunk[filled++] = (int)value;
+        }
+        add_values(st->calc, chunk, filled);
+    }
+    return 0;
+}
+
+static int parquet_read_dictionary(ParquetState* st, const uint8_t* data, size_t size,
+                                   long long count) {
+    int width = st->column->physical_type == PQ_INT32 ? 4 : 8;
+    if (count < 0 || (unsigned long long)count * width > size) {
+        return -1;
+    }
+    long long* dictionary = (long long*)realloc(st->dictionary,
+                                                (size_t)(count > 0 ? count : 1) * sizeof(long long));
+    if (dictionary == NULL) {
+        return -1;
+    }
+    for (long long i = 0; i < count; i++) {
+        if (read_int_element(data, i, width, st->column->is_signed, &dictionary[i]) != 0) {
+            dictionary[i] = LLONG_MAX;  // Rejected if a page references it
+        }
+    }
+    st->dictionary = dictionary;
+    st->dictionary_size = count;
+    return 0;
+}
+
+// Number of non-null entries given `n` definition levels
+static long long parquet_count_defined(ParquetState* st, const uint8_t* p, const uint8_t* end,
+                                       long long n) {
+    uint32_t* levels = parquet_levels(st, n);
+    if (levels == NULL || rle_decode(p, end, 1, levels, n) != 0) {
+        return -1;
+    }
+    long long defined = 0;
+    for (long long i = 0; i < n; i++) {
+        defined += levels[i] == (uint32_t)st->column->max_definition_level;
+    }
+    return defined;
+}
+
+static long long parquet_read_chunk(ParquetState* st, const MappedFile* file,
+                                    const ParquetChunk* chunk) {
+    if (chunk->num_values == 0) {
+        return 0;  // Empty row groups may point their pages at offset 0
+    }
+    if (chunk->codec != PQ_UNCOMPRESSED && chunk->codec != PQ_SNAPPY) {
+        printf("Error: Unsupported Parquet codec %d (only UNCOMPRESSED and SNAPPY)\n", chunk->codec);
+        return -1;
+    }
+    long long start = chunk->data_page_offset;
+    if (chunk->dictionary_page_offset > 0 && chunk->dictionary_page_offset < start) {
+        start = chunk->dictionary_page_offset;
+    }
+    if (start < 4 || (unsigned long long)start >= file->size) {
+        return -1;
+    }
+    ThriftReader r = {file->data + start, file->data + file->size, 0};
+    long long values_seen = 0;
+    long long added = 0;
+    while (values_seen < chunk->num_values) {
+        ParquetPage page;
+        parquet_read_page_header(&r, &page);
+        if (r.bad || page.compressed_size < 0 || page.uncompressed_size < 0 ||
+            page.compressed_size > r.end - r.p) {
+            return -1;
+        }
+        const uint8_t* payload = r.p;
+        r.p += page.compressed_size;
+
+        if (page.type == PQ_DICTIONARY_PAGE) {
+            const uint8_t* data = parquet_decompress(st, chunk->codec, payload,
+                                                     (size_t)page.compressed_size,
+                                                     (size_t)page.uncompressed_size);
+            if (data == NULL ||
+                parquet_read_dictionary(st, data, (size_t)page.uncompressed_size, page.num_values) != 0) {
+                return -1;
+            }
+            continue;
+        }
+        if (page.type != PQ_DATA_PAGE && page.type != PQ_DATA_PAGE_V2) {
+            continue;  // Index pages carry no values
+        }
+
+        long long defined = page.num_values;
+        const uint8_t* values;
+        const uint8_t* values_end;
+        if (page.type == PQ_DATA_PAGE) {
+            const uint8_t* data = parquet_decompress(st, chunk->codec, payload,
+                                                     (size_t)page.compressed_size,
+                                                     (size_t)page.uncompressed_size);
+            if (data == NULL) {
+                return -1;
+            }
+            values = data;
+            values_end = data + page.uncompressed_size;
+            if (st->column->max_definition_level > 0) {
+                if (values_end - values < 4) {
+                    return -1;
+                }
+                uint32_t levels_length = load_u32(values);
+                values += 4;
+                if (levels_length > (uint32_t)(values_end - values)) {
+                    return -1;
+                }
+                defined = parquet_count_defined(st, values, values + levels_length, page.num_values);
+                values += levels_length;
+            }
+        } else {
+            size_t levels_length = (size_t)page.definition_levels_length +
+                                   (size_t)page.repetition_levels_length;
+            if (levels_length > (size_t)page.compressed_size ||
+                levels_length > (size_t)page.uncompressed_size) {
+                return -1;
+            }
+            if (page.num_nulls >= 0) {
+                defined = page.num_values - page.num_nulls;
+            } else if (st->column->max_definition_level > 0) {
+                defined = parquet_count_defined(st, payload, payload + page.definition_levels_length,
+                                                page.num_values);
+            }
+            int codec = page.is_compressed ? chunk->codec : PQ_UNCOMPRESSED;
+            values = parquet_decompress(st, codec, payload + levels_length,
+                                        (size_t)page.compressed_size - levels_length,
+                                        (size_t)page.uncompressed_size - levels_length);
+            if (values == NULL) {
+                return -1;
+            }
+            values_end = values + (page.uncompressed_size - levels_length);
+        }
+        if (defined < 0 || defined > page.num_values ||
+            parquet_add_values(st, values, values_end, page.encoding, defined) != 0) {
+            return -1;
+        }
+        values_seen += page.num_values;
+        added += defined;
+    }
+    return added;
+}
+
+long long ingest_parquet(StatisticsCalculator* calc, const char* path, const char* column) {
+    MappedFile file;
+    if (map_file(path, &file) != 0) {
+        return -1;
+    }
+    if (file.size < 12 || memcmp(file.data, "PAR1", 4) != 0 ||
+        memcmp(file.data + file.size - 4, "PAR1", 4) != 0) {
+        printf("Error: %s is not a Parquet file\n", path);
+        unmap_file(&file);
+        return -1;
+    }
+    uint32_t footer_length = load_u32(file.data + file.size - 8);
+    if (footer_length > file.size - 12) {
+        printf("Error: Corrupt Parquet footer in %s\n", path);
+        unmap_file(&file);
+        return -1;
+    }
+    const uint8_t* footer = file.data + file.size - 8 - footer_length;
+    ThriftReader r = {footer, footer + footer_length, 0};
+
+    ParquetColumn col = {-1, 0, 1, 0};
+    ParquetState st = {calc, &col, NULL, 0, NULL, 0, NULL, 0};
+    long long added = 0;
+    int have_schema = 0;
+    int id = 0;
+    int type;
+    // FileMetaData: schema (2) precedes row_groups (4) in every known writer
+    while (added >= 0 && (type = tr_field(&r, &id)) != TT_STOP && !r.bad) {
+        if (id == 2 && type == TT_LIST) {
+            if (parquet_read_schema(&r, column, &col) != 0) {
+                added = -1;
+            }
+            have_schema = 1;
+        } else if (id == 4 && type == TT_LIST && have_schema) {
+            int elem;
+            uint32_t row_groups = tr_list(&r, &elem);
+            for (uint32_t g = 0; g < row_groups && added >= 0 && !r.bad; g++) {
+                // RowGroup: field 1 is the list of ColumnChunks
+                ParquetChunk chunk = {0, 0, 0, 0, 0};
+                int found = 0;
+                int rg_id = 0;
+                int rg_type;
+                while ((rg_type = tr_field(&r, &rg_id)) != TT_STOP && !r.bad) {
+                    if (rg_id != 1 || rg_type != TT_LIST) {
+                        tr_skip(&r, rg_type, 0);
+                        continue;
+                    }
+                    uint32_t columns = tr_list(&r, &elem);
+                    for (uint32_t c = 0; c < columns && !r.bad; c++) {
+                        int cc_id = 0;
+                        int cc_type;
+                        while ((cc_type = tr_field(&r, &cc_id)) != TT_STOP && !r.bad) {
+                            if ((int)c == col.leaf_index && cc_id == 3 && cc_type == TT_STRUCT) {
+                                parquet_read_column_meta(&r, &chunk);
+                                found = 1;
+                            } else {
+                                tr_skip(&r, cc_type, 0);
+                            }
+                        }
+                    }
+                }
+                if (found && !r.bad) {
+                    long long n = parquet_read_chunk(&st, &file, &chunk);
+                    if (n < 0) {
+                        printf("Error: Cannot decode Parquet column chunk in %s\n", path);
+                        added = -1;
+                    } else {
+                        added += n;
+                    }
+                }
+                free(st.dictionary);  // Dictionaries are per column chunk
+                st.dictionary = NULL;
+                st.dictionary_size = 0;
+            }
+        } else {
+            tr_skip(&r, type, 0);
+        }
+    }
+    if (r.bad && added >= 0) {
+        printf("Error: Malformed Parquet metadata in %s\n", path);
+        added = -1;
+    }
+    free(st.dictionary);
+    free(st.scratch);
+    free(st.levels);
+    unmap_file(&file);
+    return added;
+}
+
+// Dispatch on the file magic: Parquet, Arrow IPC file or Arrow IPC stream
+long long ingest_columnar_file(StatisticsCalculator* calc, const char* path, const char* column) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        printf("Error: Cannot open %s\n", path);
+        return -1;
+    }
+    unsigned char magic[4] = {0};
+    size_t n = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+    if (n == 4 && memcmp(magic, "PAR1", 4) == 0) {
+        return ingest_parquet(calc, path, column);
+    }
+    return ingest_arrow_ipc(calc, path, column);
+}
+
+#ifndef COLUMNAR_NO_MAIN
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        printf("Usage: %s <file.arrow|file.parquet> [column]\n", argv[0]);
+        return 1;
+    }
+    StatisticsCalculator* calc = create_calculator();
+    if (calc == NULL) {
+        return 1;
+    }
+    long long added = ingest_columnar_file(calc, argv[1], argc == 3 ? argv[2] : NULL);
+    if (added >= 0) {
+        printf("Ingested %lld values from %s\n", added, argv[1]);
+        print_summary(calc);
+    }
+    free_calculator(calc);
+    return added >= 0 ? 0 : 1;
+}
+#endif /* COLUMNAR_NO_MAIN */
+
+#endif /* MULTIPARADIGM_COLUMNAR_INCLUDED */
@@ -0,0 +1,652 @@
+/*
+ * Asynchronous multi-file ingestion for the C StatisticsCalculator.
+ *
+ * Files are split into fixed-size chunks that are read ahead through a ring of
+ * buffers, keeping up to `queue_depth` reads in flight while the calling
+ * thread parses completed chunks and feeds them to add_values(). Reads go
+ * through io_uring (raw syscalls, no liburing needed); where io_uring is not
+ * available (old kernel, seccomp) a small thread pool issues pread() instead.
+ *
+ * Chunks are issued in file order and consumed in the same order, so buffer
+ * slots are recycled round-robin and values reach the calculator in the
+ * order they appear in the files.
+ *
+ * Formats:
+ *   text    whitespace-separated decimal integers (as read by the --bench modes)
+ *   binary  native-endian int32 values
+ *
+ * Build:
+ *   gcc -O2 -pthread MultiParadigmIngest.c -o ingest -lm
+ *   ./ingest [--binary] [--threads|--io-uring] [--depth N] [--chunk KB] [--summary] file...
+ */
+
+#ifndef MULTIPARADIGM_INGEST_INCLUDED
+#define MULTIPARADIGM_INGEST_INCLUDED
+
+#define STATS_NO_MAIN
+#include "MultiParadigmC.c"
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#define INGEST_DEFAULT_DEPTH 32
+#define INGEST_DEFAULT_CHUNK (1 << 20)
+#define INGEST_DEFAULT_THREADS 8
+#define INGEST_BATCH 65536
+
+typedef enum { INGEST_TEXT, INGEST_BINARY } IngestFormat;
+typedef enum { INGEST_AUTO, INGEST_IO_URING, INGEST_THREADS } IngestBackendKind;
+
+typedef struct {
+    IngestFormat format;
+    IngestBackendKind backend;
+    int queue_depth;      // Reads in flight; 0 selects INGEST_DEFAULT_DEPTH
+    size_t chunk_size;    // Bytes per read, rounded to 4 KiB; 0 selects INGEST_DEFAULT_CHUNK
+    int threads;          // Thread-pool size; 0 selects INGEST_DEFAULT_THREADS
+} IngestConfig;
+
+typedef struct {
+    long long values;
+    long long bytes;
+    double seconds;
+    const char* backend;  // "io_uring" or "threads"
+} IngestStats;
+
+typedef struct {
+    int fd;
+    int file;
+    off_t offset;
+    size_t length;
+    size_t done;          // Bytes read so far
+    ssize_t error;        // Negative errno from the read
+    int complete;
+    int last;             // Final chunk of its file
+    unsigned char* data;
+    struct iovec iov;
+} ReadSlot;
+
+typedef struct {
+    int fd;
+    unsigned char* sq_ring;
+    size_t sq_ring_size;
+    unsigned char* cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+    unsigned unsubmitted;
+} Uring;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t done_ready;
+    ReadSlot** queue;     // Requests, FIFO of `depth` entries
+    ReadSlot** finished;  // Completions, FIFO of `depth` entries
+    int depth;
+    int queue_head, queue_count;
+    int finished_head, finished_count;
+    int stopping;
+    pthread_t* threads;
+    int thread_count;
+} ReadPool;
+
+typedef struct {
+    IngestBackendKind kind;
+    Uring ring;
+    ReadPool pool;
+} ReadBackend;
+
+// ---------------------------------------------------------------------------
+// io_uring backend
+
+static int uring_setup(Uring* ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        return -1;
+    }
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sq_ring = (unsigned char*)mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    ring->cq_ring = (unsigned char*)mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        if (ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+        if (ring->cq_ring != MAP_FAILED) munmap(ring->cq_ring, ring->cq_ring_size);
+        if (ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+        close(ring->fd);
+        return -1;
+    }
+    ring->sq_head = (unsigned*)(ring->sq_ring + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(ring->sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(ring->sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(ring->sq_ring + params.sq_off.array);
+    ring->cq_head = (unsigned*)(ring->cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(ring->cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(ring->cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(ring->cq_ring + params.cq_off.cqes);
+    return 0;
+}
+
+static void uring_destroy(Uring* ring) {
+    munmap(ring->sqes, ring->sqes_size);
+    munmap(ring->cq_ring, ring->cq_ring_size);
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(ring->fd);
+}
+
+// Queue a read of the slot's remaining bytes; submitted by the next uring_wait()
+static void uring_queue(Uring* ring, ReadSlot* slot) {
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    slot->iov.iov_base = slot->data + slot->done;
+    slot->iov.iov_len = slot->length - slot->done;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;  // READV (5.1) rather than READ (5.6) for older kernels
+    sqe->fd = slot->fd;
+    sqe->off = (uint64_t)(slot->offset + (off_t)slot->done);
+    sqe->addr = (uint64_t)(uintptr_t)&slot->iov;
+    sqe->len = 1;
+    sqe->user_data = (uint64_t)(uintptr_t)slot;
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->unsubmitted++;
+}
+
+// Hand queued reads to the kernel without waiting
+static int uring_submit(Uring* ring) {
+    while (ring->unsubmitted > 0) {
+        int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, ring->unsubmitted, 0, 0, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        ring->unsubmitted -= (unsigned)submitted;
+    }
+    return 0;
+}
+
+// Submit queued reads and wait for one completion
+static ReadSlot* uring_wait(Uring* ring, ssize_t* result) {
+    for (;;) {
+        unsigned head = *ring->cq_head;
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+            ReadSlot* slot = (ReadSlot*)(uintptr_t)cqe->user_data;
+            *result = cqe->res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+            return slot;
+        }
+        int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, ring->unsubmitted, 1,
+                                     IORING_ENTER_GETEVENTS, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            return NULL;
+        }
+        ring->unsubmitted -= (unsigned)submitted;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Thread-pool backend
+
+static void* read_pool_worker(void* arg) {
+    ReadPool* pool = (ReadPool*)arg;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->queue_count == 0 && !pool->stopping) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->queue_count == 0) {
+            break;
+        }
+        ReadSlot* slot = pool->queue[pool->queue_head];
+        pool->queue_head = (pool->queue_head + 1) % pool->depth;
+        pool->queue_count--;
+        pthread_mutex_unlock(&pool->lock);
+
+        while (slot->done < slot->length) {
+            ssize_t n = pread(slot->fd, slot->data + slot->done, slot->length - slot->done,
+                              slot->offset + (off_t)slot->done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                slot->error = n < 0 ? -errno : 0;
+                break;
+            }
+            slot->done += (size_t)n;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        pool->finished[(pool->finished_head + pool->finished_count) % pool->depth] = slot;
+        pool->finished_count++;
+        pthread_cond_signal(&pool->done_ready);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static int read_pool_start(ReadPool* pool, int depth, int threads) {
+    memset(pool, 0, sizeof(*pool));
+    pool->depth = depth;
+    pool->queue = (ReadSlot**)malloc((size_t)depth * sizeof(ReadSlot*));
+    pool->finished = (ReadSlot**)malloc((size_t)depth * sizeof(ReadSlot*));
+    pool->threads = (pthread_t*)malloc((size_t)threads * sizeof(pthread_t));
+    if (pool->queue == NULL || pool->finished == NULL || pool->threads == NULL) {
+        printf("Memory allocation failed\n");
+        free(pool->queue);
+        free(pool->finished);
+        free(pool->threads);
+        return -1;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->done_ready, NULL);
+    while (pool->thread_count < threads &&
+           pthread_create(&pool->threads[pool->thread_count], NULL, read_pool_worker, pool) == 0) {
+        pool->thread_count++;
+    }
+    return pool->thread_count > 0 ? 0 : -1;
+}
+
+static void read_pool_stop(ReadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done_ready);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->queue);
+    free(pool->finished);
+    free(pool->threads);
+}
+
+static void read_pool_queue(ReadPool* pool, ReadSlot* slot) {
+    pthread_mutex_lock(&pool->lock);
+    pool->queue[(pool->queue_head + pool->queue_count) % pool->depth] = slot;
+    pool->queue_count++;
+    pthread_cond_signal(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static ReadSlot* read_pool_wait(ReadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->finished_count == 0) {
+        pthread_cond_wait(&pool->done_ready, &pool->lock);
+    }
+    ReadSlot* slot = pool->finished[pool->finished_head];
+    pool->finished_head = (pool->finished_head + 1) % pool->depth;
+    pool->finished_count--;
+    pthread_mutex_unlock(&pool->lock);
+    return slot;
+}
+
+// ---------------------------------------------------------------------------
+// Backend selection
+
+static int backend_start(ReadBackend* backend, const IngestConfig* config) {
+    backend->kind = config->backend;
+    if (backend->kind != INGEST_THREADS) {
+        if (uring_setup(&backend->ring, (unsigned)config->queue_depth) == 0) {
+            backend->kind = INGEST_IO_URING;
+            return 0;
+        }
+        if (backend->kind == INGEST_IO_URING) {
+            printf("Error: io_uring is not available\n");
+            return -1;
+        }
+    }
+    backend->kind = INGEST_THREADS;
+    return read_pool_start(&backend->pool, config->queue_depth, config->threads);
+}
+
+static void backend_stop(ReadBackend* backend) {
+    if (backend->kind == INGEST_IO_URING) {
+        uring_destroy(&backend->ring);
+    } else {
+        read_pool_stop(&backend->pool);
+    }
+}
+
+static void backend_queue(ReadBackend* backend, ReadSlot* slot) {
+    if (backend->kind == INGEST_IO_URING) {
+        uring_queue(&backend->ring, slot);
+    } else {
+        read_pool_queue(&backend->pool, slot);
+    }
+}
+
+static int backend_submit(ReadBackend* backend) {
+    return backend->kind == INGEST_IO_URING ? uring_submit(&backend->ring) : 0;
+}
+
+// Wait until some slot has finished reading, resubmitting short io_uring reads
+static int backend_wait(ReadBackend* backend) {
+    if (backend->kind == INGEST_THREADS) {
+        read_pool_wait(&backend->pool)->complete = 1;
+        return 0;
+    }
+    ssize_t result;
+    ReadSlot* slot = uring_wait(&backend->ring, &result);
+    if (slot == NULL) {
+        return -1;
+    }
+    if (result > 0) {
+        slot->done += (size_t)result;
+        if (slot->done < slot->length) {
+            uring_queue(&backend->ring, slot);
+            return 0;
+        }
+    } else {
+        slot->error = result;  // 0 means the file shrank under us
+    }
+    slot->complete = 1;
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Parsing
+
+typedef struct {
+    StatisticsCalculator* calc;
+    int* batch;
+    int batch_count;
+    long long value;
+    int sign;             // 0 before a token, then -1 or 1
+    int digits;
+    long long values;
+} ChunkParser;
+
+static void flush_batch(ChunkParser* parser) {
+    if (parser->batch_count > 0) {
+        add_values(parser->calc, parser->batch, parser->batch_count);
+        parser->values += parser->batch_count;
+        parser->batch_count = 0;
+    }
+}
+
+static int end_token(ChunkParser* parser) {
+    if (parser->sign == 0) {
+        return 0;
+    }
+    long long v = parser->sign * parser->value;
+    if (parser->digits == 0 || v < INT_MIN || v > INT_MAX) {
+        printf("Error: Invalid or out-of-range integer\n");
+        return -1;
+    }
+    parser->batch[parser->batch_count++] = (int)v;
+    if (parser->batch_count == INGEST_BATCH) {
+        flush_batch(parser);
+    }
+    parser->sign = 0;
+    parser->digits = 0;
+    parser->value = 0;
+    return 0;
+}
+
+// Parse decimal integers; a token cut by the chunk boundary carries over
+static int parse_text_chunk(ChunkParser* parser, const unsigned char* p, size_t size, int last) {
+    const unsigned char* end = p + size;
+    while (p < end) {
+        unsigned char c = *p++;
+        if (c >= '0' && c <= '9') {
+            long long value = parser->value * 10 + (c - '0');
+            int digits = parser->digits + 1;
+            while (p < end && *p >= '0' && *p <= '9' && value <= (long long)INT_MAX + 1) {
+                value = value * 10 + (*p++ - '0');
+                digits++;
+            }
+            if (parser->sign == 0) {
+                parser->sign = 1;
+            }
+            parser->value = value;
+            parser->digits = digits;
+        } else if (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+            if (end_token(parser) != 0) {
+                return -1;
+            }
+        } else if ((c == '-' || c == '+') && parser->sign == 0) {
+            parser->sign = c == '-' ? -1 : 1;
+        } else {
+            printf("Error: Unexpected character '%c' in input\n", c);
+            return -1;
+        }
+    }
+    return last ? end_token(parser) : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Driver
+
+static double monotonic_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Ingest every file into `calc`, returning the number of values added or -1
+long long ingest_files(StatisticsCalculator* calc, const char* const paths[], int file_count,
+                       const IngestConfig* config, IngestStats* stats) {
+    IngestConfig settings = config != NULL ? *config : (IngestConfig){INGEST_TEXT, INGEST_AUTO, 0, 0, 0};
+    if (settings.queue_depth <= 0) settings.queue_depth = INGEST_DEFAULT_DEPTH;
+    if (settings.threads <= 0) settings.threads = INGEST_DEFAULT_THREADS;
+    if (settings.chunk_size == 0) settings.chunk_size = INGEST_DEFAULT_CHUNK;
+    settings.chunk_size = (settings.chunk_size + 4095) & ~(size_t)4095;
+
+    int* fds = (int*)malloc((size_t)(file_count > 0 ? file_count : 1) * sizeof(int));
+    off_t* sizes = (off_t*)malloc((size_t)(file_count > 0 ? file_count : 1) * sizeof(off_t));
+    ReadSlot* slots = (ReadSlot*)calloc((size_t)settings.queue_depth, sizeof(ReadSlot));
+    unsigned char* buffers = (unsigned char*)aligned_alloc(4096, (size_t)settings.queue_depth * settings.chunk_size);
+    ChunkParser parser = {calc, (int*)malloc(INGEST_BATCH * sizeof(int)), 0, 0, 0, 0, 0};
+    int opened = 0;
+    long long status = -1;
+    ReadBackend backend;
+    int backend_running = 0;
+    double start = 0.0;
+    long long bytes = 0;
+
+    if (fds == NULL || sizes == NULL || slots == NULL || buffers == NULL || parser.batch == NULL) {
+        printf("Memory allocation failed\n");
+        goto done;
+    }
+    for (; opened < file_count; opened++) {
+        struct stat st;
+        fds[opened] = open(paths[opened], O_RDONLY | O_CLOEXEC);
+        if (fds[opened] < 0 || fstat(fds[opened], &st) != 0) {
+            printf("Error: Cannot open %s\n", paths[opened]);
+            if (fds[opened] >= 0) close(fds[opened]);
+            goto done;
+        }
+        sizes[opened] = st.st_size;
+        if (settings.format == INGEST_BINARY && st.st_size % (off_t)sizeof(int) != 0) {
+            printf("Error: %s is not a whole number of int32 values\n", paths[opened]);
+            close(fds[opened]);
+            goto done;
+        }
+        posix_fadvise(fds[opened], 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    if (settings.format == INGEST_BINARY) {
+        // The value count is known up front, so grow the calculator once
+        off_t total = 0;
+        for (int i = 0; i < file_count; i++) {
+            total += sizes[i] / (off_t)sizeof(int);
+        }
+        if (total > INT_MAX - calc->count || reserve_capacity(calc, calc->count + (int)total) != 0) {
+            printf("Error: Too many values for one calculator\n");
+            goto done;
+        }
+    }
+    if (backend_start(&backend, &settings) != 0) {
+        goto done;
+    }
+    backend_running = 1;
+    for (int i = 0; i < settings.queue_depth; i++) {
+        slots[i].data = buffers + (size_t)i * settings.chunk_size;
+    }
+
+    start = monotonic_time();
+    long long issued = 0, consumed = 0;
+    int next_file = 0;
+    off_t next_offset = 0;
+    status = 0;
+    for (;;) {
+        // Keep the ring full: issue chunks in file order
+        while (issued - consumed < settings.queue_depth && next_file < file_count) {
+            if (next_offset >= sizes[next_file]) {
+                next_file++;
+                next_offset = 0;
+                continue;
+            }
+            ReadSlot* slot = &slots[issued % settings.queue_depth];
+            slot->fd = fds[next_file];
+            slot->file = next_file;
+            slot->offset = next_offset;
+            slot->length = (size_t)(sizes[next_file] - next_offset) < settings.chunk_size
+                               ? (size_t)(sizes[next_file] - next_offset) : settings.chunk_size;
+            slot->done = 0;
+            slot->error = 0;
+            slot->complete = 0;
+            next_offset += (off_t)slot->length;
+            slot->last = next_offset >= sizes[next_file];
+            backend_queue(&backend, slot);
+            issued++;
+        }
+        if (backend_submit(&backend) != 0) {
+            printf("Error: Asynchronous read failed\n");
+            status = -1;
+            break;
+        }
+        if (consumed == issued) {
+            break;
+        }
+        // Consume finished chunks in issue order while later reads proceed
+        ReadSlot* slot = &slots[consumed % settings.queue_depth];
+        if (!slot->complete) {
+            if (backend_wait(&backend) != 0) {
+                printf("Error: Asynchronous read failed\n");
+                status = -1;
+                break;
+            }
+            continue;
+        }
+        if (slot->error < 0) {
+            printf("Error: Cannot read %s: %s\n", paths[slot->file], strerror((int)-slot->error));
+            status = -1;
+            break;
+        }
+        bytes += (long long)slot->done;
+        int last = slot->last || slot->done < slot->length;
+        if (settings.format == INGEST_BINARY) {
+            flush_batch(&parser);
+            add_values(calc, (const int*)slot->data, (int)(slot->done / sizeof(int)));
+            parser.values += (long long)(slot->done / sizeof(int));
+        } else if (parse_text_chunk(&parser, slot->data, slot->done, last) != 0) {
+            printf("Error: Cannot parse %s\n", paths[slot->file]);
+            status = -1;
+            break;
+        }
+        consumed++;
+    }
+    if (status == 0) {
+        flush_batch(&parser);
+        status = parser.values;
+    } else {
+        // Let outstanding reads land before their buffers are freed
+        while (consumed < issued) {
+            ReadSlot* slot = &slots[consumed % settings.queue_depth];
+            if (!slot->complete && backend_wait(&backend) != 0) {
+                break;
+            }
+            consumed += slot->complete;
+        }
+    }
+
+done:
+    if (backend_running) {
+        backend_stop(&backend);
+    }
+    if (stats != NULL) {
+        stats->values = parser.values;
+        stats->bytes = bytes;
+        stats->seconds = start > 0.0 ? monotonic_time() - start : 0.0;
+        stats->backend = backend_running && backend.kind == INGEST_IO_URING ? "io_uring" : "threads";
+    }
+    for (int i = 0; i < opened; i++) {
+        close(fds[i]);
+    }
+    free(fds);
+    free(sizes);
+    free(slots);
+    free(buffers);
+    free(parser.batch);
+    return status;
+}
+
+#ifndef INGEST_NO_MAIN
+int main(int argc, char** argv) {
+    IngestConfig config = {INGEST_TEXT, INGEST_AUTO, 0, 0, 0};
+    int summary = 0;
+    int first = 1;
+    for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++) {
+        if (strcmp(argv[first], "--binary") == 0) {
+            config.format = INGEST_BINARY;
+        } else if (strcmp(argv[first], "--summary") == 0) {
+            summary = 1;
+        } else if (strcmp(argv[first], "--threads") == 0) {
+            config.backend = INGEST_THREADS;
+        } else if (strcmp(argv[first], "--io-uring") == 0) {
+            config.backend = INGEST_IO_URING;
+        } else if (strcmp(argv[first], "--depth") == 0 && first + 1 < argc) {
+            config.queue_depth = atoi(argv[++first]);
+        } else if (strcmp(argv[first], "--chunk") == 0 && first + 1 < argc) {
+            config.chunk_size = (size_t)atol(argv[++first]) * 1024;
+        } else {
+            break;
+        }
+    }
+    if (first >= argc) {
+        printf("Usage: %s [--binary] [--threads|--io-uring] [--depth N] [--chunk KB] [--summary] file...\n",
+               argv[0]);
+        return 1;
+    }
+    StatisticsCalculator* calc = create_calculator();
+    if (calc == NULL) {
+        return 1;
+    }
+    IngestStats stats;
+    long long added = ingest_files(calc, (const char* const*)&argv[first], argc - first, &config, &stats);
+    if (added >= 0) {
+        printf("Ingested %lld values (%.1f MB) from %d file(s) in %.3f s: %.1f MB/s via %s\n",
+               added, stats.bytes / 1e6, argc - first, stats.seconds,
+               stats.seconds > 0 ? stats.bytes / 1e6 / stats.seconds : 0.0, stats.backend);
+        if (summary) {
+            print_summary(calc);
+        }
+    }
+    free_calculator(calc);
+    return added >= 0 ? 0 : 1;
+}
+#endif /* INGEST_NO_MAIN */
+
+#endif /* MULTIPARADIGM_INGEST_INCLUDED */
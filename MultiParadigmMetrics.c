@@ -0,0 +1,258 @@
+/*
+ * Prometheus/OpenMetrics endpoint for the C StatisticsCalculator.
+ *
+ * A tiny HTTP/1.1 listener on 127.0.0.1 that answers GET /metrics with the
+ * text produced by a render callback, normally write_openmetrics(). The
+ * callback gets the listener's reusable buffer and returns the full length,
+ * so an exposition larger than the buffer is re-rendered once into a bigger
+ * one; the second pass only reads the caches the first one filled. Requests
+ * are served one at a time on a single background thread, which is plenty
+ * for a scraper.
+ *
+ * MultiParadigmServer.c mounts this when given a metrics port. Standalone, it
+ * loads each dataset file into a calculator named after the file.
+ *
+ * Build:
+ *   gcc -O2 -pthread MultiParadigmMetrics.c -o metrics -lm
+ *   ./metrics <port> file...
+ *   curl http://127.0.0.1:<port>/metrics
+ */
+
+#ifndef MULTIPARADIGM_METRICS_INCLUDED
+#define MULTIPARADIGM_METRICS_INCLUDED
+
+#define STATS_NO_MAIN
+#include "MultiParadigmC.c"
+
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define METRICS_INITIAL_BUFFER 65536
+#define METRICS_MAX_REQUEST 8192
+#define METRICS_CONTENT_TYPE "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+// Render the exposition into `buffer`, returning its full length (snprintf-style)
+typedef size_t (*MetricsRenderFn)(void* context, char* buffer, size_t size);
+
+typedef struct {
+    int fd;
+    pthread_t thread;
+    volatile int stopping;
+    MetricsRenderFn render;
+    void* context;
+    char* buffer;
+    size_t buffer_size;
+} MetricsListener;
+
+static int send_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return -1;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return 0;
+}
+
+static void send_response(int fd, const char* status, const char* content_type, const char* body, size_t length) {
+    char header[256];
+    int header_length = snprintf(header, sizeof(header),
+                                 "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                                 "Connection: close\r\n\r\n", status, content_type, length);
+    if (send_all(fd, header, (size_t)header_length) == 0) {
+        send_all(fd, body, length);
+    }
+}
+
+static void serve_scrape(MetricsListener* listener, int fd) {
+    char request[METRICS_MAX_REQUEST + 1];
+    size_t received = 0;
+    while (received < METRICS_MAX_REQUEST) {
+        ssize_t n = recv(fd, request + received, METRICS_MAX_REQUEST - received, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        received += (size_t)n;
+        request[received] = '\0';
+        if (strstr(request, "\r\n\r\n") != NULL) break;
+    }
+    request[received] = '\0';
+    const char* not_found = "Not found\n";
+    if (strncmp(request, "GET /metrics ", 13) != 0 && strncmp(request, "GET /metrics?", 13) != 0) {
+        send_response(fd, "404 Not Found", "text/plain", not_found, strlen(not_found));
+        return;
+    }
+
+    size_t length = listener->render(listener->context, listener->buffer, listener->buffer_size);
+    if (length >= listener->buffer_size) {
+        char* grown = (char*)realloc(listener->buffer, length + 1);
+        if (grown == NULL) {
+            printf("Memory allocation failed\n");
+            const char* error = "Out of memory\n";
+            send_response(fd, "500 Internal Server Error", "text/plain", error, strlen(error));
+            return;
+        }
+        listener->buffer = grown;
+        listener->buffer_size = length + 1;
+        length = listener->render(listener->context, listener->buffer, listener->buffer_size);
+        if (length >= listener->buffer_size) {
+            length = listener->buffer_size - 1;  // Grew again between passes; serve what fits
+        }
+    }
+    send_response(fd, "200 OK", METRICS_CONTENT_TYPE, listener->buffer, length);
+}
+
+static void* metrics_thread(void* arg) {
+    MetricsListener* listener = (MetricsListener*)arg;
+    struct pollfd poll_fd = {listener->fd, POLLIN, 0};
+    while (!listener->stopping) {
+        if (poll(&poll_fd, 1, 200) <= 0) {
+            continue;
+        }
+        int fd = accept4(listener->fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        struct timeval timeout = {5, 0};  // A stalled client must not block the next scrape
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        serve_scrape(listener, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+// Serve GET /metrics on 127.0.0.1:port from a background thread
+MetricsListener* start_metrics_listener(int port, MetricsRenderFn render, void* context) {
+    MetricsListener* listener = (MetricsListener*)calloc(1, sizeof(MetricsListener));
+    if (listener == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    listener->render = render;
+    listener->context = context;
+    listener->buffer_size = METRICS_INITIAL_BUFFER;
+    listener->buffer = (char*)malloc(listener->buffer_size);
+    listener->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    // The thread inherits a mask without SIGINT/SIGTERM, leaving them to the caller
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    int reuse = 1;
+    int started = 0;
+    if (listener->buffer != NULL && listener->fd >= 0 &&
+        setsockopt(listener->fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == 0 &&
+        bind(listener->fd, (struct sockaddr*)&address, sizeof(address)) == 0 &&
+        listen(listener->fd, 16) == 0) {
+        pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+        started = pthread_create(&listener->thread, NULL, metrics_thread, listener) == 0;
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    }
+    if (!started) {
+        printf("Error: Cannot serve metrics on port %d\n", port);
+        if (listener->fd >= 0) close(listener->fd);
+        free(listener->buffer);
+        free(listener);
+        return NULL;
+    }
+    return listener;
+}
+
+void stop_metrics_listener(MetricsListener* listener) {
+    if (listener == NULL) {
+        return;
+    }
+    listener->stopping = 1;
+    pthread_join(listener->thread, NULL);
+    close(listener->fd);
+    free(listener->buffer);
+    free(listener);
+}
+
+#ifndef METRICS_NO_MAIN
+typedef struct {
+    const char** names;
+    StatisticsCalculator** calcs;
+    int count;
+} FileMetrics;
+
+static size_t render_files(void* context, char* buffer, size_t size) {
+    FileMetrics* files = (FileMetrics*)context;
+    return write_openmetrics("statistics_samples", files->names, files->calcs, files->count, NULL, buffer, size);
+}
+
+static volatile sig_atomic_t metrics_stopping = 0;
+
+static void stop_metrics(int signal_number) {
+    (void)signal_number;
+    metrics_stopping = 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: %s <port> file...\n", argv[0]);
+        return 1;
+    }
+    int count = argc - 2;
+    FileMetrics files = {(const char**)malloc((size_t)count * sizeof(char*)),
+                         (StatisticsCalculator**)calloc((size_t)count, sizeof(StatisticsCalculator*)), count};
+    if (files.names == NULL || files.calcs == NULL) {
+        printf("Memory allocation failed\n");
+        return 1;
+    }
+    int status = 0;
+    for (int i = 0; i < count && status == 0; i++) {
+        const char* path = argv[i + 2];
+        const char* slash = strrchr(path, '/');
+        files.names[i] = slash != NULL ? slash + 1 : path;
+        files.calcs[i] = create_calculator();
+        FILE* file = fopen(path, "r");
+        if (files.calcs[i] == NULL || file == NULL) {
+            printf("Error: Cannot open dataset %s\n", path);
+            status = 1;
+            break;
+        }
+        int value;
+        while (fscanf(file, "%d", &value) == 1) {
+            add_value(files.calcs[i], value);
+        }
+        fclose(file);
+    }
+
+    MetricsListener* listener = status == 0 ? start_metrics_listener(atoi(argv[1]), render_files, &files) : NULL;
+    if (listener != NULL) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = stop_metrics;
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+        printf("Serving metrics for %d calculator(s) on http://127.0.0.1:%s/metrics\n", count, argv[1]);
+        fflush(stdout);
+        while (!metrics_stopping) {
+            pause();
+        }
+        stop_metrics_listener(listener);
+    } else {
+        status = 1;
+    }
+    for (int i = 0; i < count; i++) {
+        free_calculator(files.calcs[i]);
+    }
+    free(files.names);
+    free(files.calcs);
+    return status;
+}
+#endif /* METRICS_NO_MAIN */
+
+#endif /* MULTIPARADIGM_METRICS_INCLUDED */
@@ -342,7 +342,48 @@ let example_6 () =
     List.iter (Printf.printf "%d ") outliers;
     Printf.printf "\n"
 
-let () =
+(* Benchmark runner used by MultiParadigmBench.py: one tab-separated line per
+   operation with its size, CPU time, peak heap size in KB and the result. *)
+let read_dataset path =
+  let ib = Scanf.Scanning.open_in path in
+  let rec loop acc =
+    match Scanf.bscanf ib " %d" (fun x -> x) with
+    | x -> loop (x :: acc)
+    | exception (End_of_file | Scanf.Scan_failure _) -> List.rev acc
+  in
+  let values = loop [] in
+  Scanf.Scanning.close_in ib;
+  values
+
+let run_benchmark path =
+  let values = read_dataset path in
+  let size = List.length values in
+  let peak_heap_kb () = (Gc.quick_stat ()).Gc.top_heap_words * (Sys.word_size / 8) / 1024 in
+  let operations = [
+    ("add_values", None);
+    ("mean", Some (fun calc -> Printf.sprintf "%.17g" (calculate_mean calc)));
+    ("median", Some (fun calc -> Printf.sprintf "%.17g" (calculate_median calc)));
+    ("mode", Some (fun calc ->
+       String.concat "," (ListUtils.map string_of_int (calculate_mode calc))));
+    ("std_dev_sample", Some (fun calc -> Printf.sprintf "%.17g" (calculate_std_dev calc false)));
+    ("std_dev_population", Some (fun calc -> Printf.sprintf "%.17g" (calculate_std_dev calc true)));
+    ("range", Some (fun calc -> string_of_int (calculate_range calc)));
+  ] in
+  List.iter (fun (name, operation) ->
+    let calc = create_calculator () in
+    let start = Sys.time () in
+    add_values calc values;
+    let loaded = Sys.time () in
+    let elapsed, result = match operation with
+      | None -> (loaded -. start, string_of_int size)
+      | Some f ->
+        let result = f calc in
+        (Sys.time () -. loaded, result)
+    in
+    Printf.printf "%s\t%d\t%.9f\t%d\t%s\n" name size elapsed (peak_heap_kb ()) result)
+    operations
+
+let run_examples () =
   Printf.printf "============================================================\n";
   Printf.printf "        Statistics Calculator Demonstration (OCaml Version)\n";
   Printf.printf "============================================================\n";
@@ -357,3 +398,9 @@ let () =
   Printf.printf "\n============================================================\n";
   Printf.printf "              All examples completed successfully!\n";
   Printf.printf "============================================================\n"
+
+let () =
+  if Array.length Sys.argv >= 3 && Sys.argv.(1) = "--bench" then
+    run_benchmark Sys.argv.(2)
+  else
+    run_examples ()
@@ -0,0 +1,33 @@
+(* OCaml interface to the C StatisticsCalculator engine *)
+
+(* Mirrors the API of MultiParadigmOCaml.ml, but data lives in the C engine's
+   contiguous buffers, so median, mode and range share its sort and scan
+   kernels instead of walking linked lists. Int32 Bigarrays are read in place
+   by add_bigarray without an intermediate copy. *)
+
+type t
+
+type int32_vector = (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+external create_calculator : unit -> t = "mp_create_calculator"
+external add_value : t -> int -> unit = "mp_add_value"
+external add_array : t -> int array -> unit = "mp_add_array"
+external add_bigarray : t -> (int32, Bigarray.int32_elt, 'layout) Bigarray.Array1.t -> unit
+  = "mp_add_bigarray"
+external clear_data : t -> unit = "mp_clear_data" [@@noalloc]
+external count : t -> int = "mp_count" [@@noalloc]
+external calculate_mean : t -> float = "mp_calculate_mean"
+external calculate_median : t -> float = "mp_calculate_median"
+external calculate_mode_array : t -> int array = "mp_calculate_mode"
+external calculate_std_dev : t -> bool -> float = "mp_calculate_std_dev"
+external calculate_range : t -> int = "mp_calculate_range"
+external print_summary : t -> unit = "mp_print_summary"
+
+let add_values calc values = add_array calc (Array.of_list values)
+
+let calculate_mode calc = Array.to_list (calculate_mode_array calc)
+
+let of_bigarray (data : int32_vector) =
+  let calc = create_calculator () in
+  add_bigarray calc data;
+  calc
@@ -0,0 +1,166 @@
+/*
+ * OCaml stubs for the C StatisticsCalculator (see MultiParadigmOCamlEngine.ml).
+ *
+ * The calculator lives in a custom block finalised by the GC. Int32 Bigarrays
+ * are passed to the engine by pointer: their storage is outside the OCaml heap,
+ * so add_values() reads it directly without a copy. The engine has no locking
+ * of its own, so every stub keeps the runtime lock held; that is what
+ * serialises systhreads sharing a calculator.
+ *
+ * Build:
+ *   ocamlfind ocamlopt -c MultiParadigmOCamlStubs.c
+ *   ocamlfind ocamlopt -c MultiParadigmOCamlEngine.ml
+ *   ocamlfind ocamlmklib -o multiparadigm_stats MultiParadigmOCamlStubs.o \
+ *       MultiParadigmOCamlEngine.cmx -lm
+ */
+
+#define CAML_NAME_SPACE
+#include <caml/mlvalues.h>
+#include <caml/alloc.h>
+#include <caml/memory.h>
+#include <caml/custom.h>
+#include <caml/fail.h>
+#include <caml/bigarray.h>
+
+#define STATS_NO_MAIN
+#include "MultiParadigmC.c"
+
+#define CONVERT_CHUNK 1024
+
+#define Calc_val(v) (*((StatisticsCalculator**)Data_custom_val(v)))
+
+static void finalize_calculator(value v) {
+    free_calculator(Calc_val(v));
+    Calc_val(v) = NULL;
+}
+
+static struct custom_operations calculator_ops = {
+    "multiparadigm.statistics_calculator",
+    finalize_calculator,
+    custom_compare_default,
+    custom_hash_default,
+    custom_serialize_default,
+    custom_deserialize_default,
+    custom_compare_ext_default,
+    custom_fixed_length_default
+};
+
+static int ml_to_int(value v) {
+    intnat n = Long_val(v);
+    if (n < INT_MIN || n > INT_MAX) {
+        caml_invalid_argument("MultiParadigmOCamlEngine: value does not fit in a C int");
+    }
+    return (int)n;
+}
+
+CAMLprim value mp_create_calculator(value unit) {
+    CAMLparam1(unit);
+    CAMLlocal1(result);
+    StatisticsCalculator* calc = create_calculator();
+    if (calc == NULL) {
+        caml_raise_out_of_memory();
+    }
+    result = caml_alloc_custom_mem(&calculator_ops, sizeof(StatisticsCalculator*),
+                                   sizeof(StatisticsCalculator));
+    Calc_val(result) = calc;
+    CAMLreturn(result);
+}
+
+CAMLprim value mp_add_value(value calc, value v) {
+    add_value(Calc_val(calc), ml_to_int(v));
+    return Val_unit;
+}
+
+CAMLprim value mp_add_array(value calc, value values) {
+    CAMLparam2(calc, values);
+    StatisticsCalculator* c = Calc_val(calc);
+    mlsize_t n = Wosize_val(values);
+    if (n > (mlsize_t)(INT_MAX - c->count)) {
+        caml_invalid_argument("MultiParadigmOCamlEngine.add_array: too many values");
+    }
+    for (mlsize_t i = 0; i < n; i++) {
+        ml_to_int(Field(values, i));  // Validate up front so a failure adds nothing
+    }
+    if (reserve_capacity(c, c->count + (int)n) != 0) {
+        caml_raise_out_of_memory();
+    }
+    int chunk[CONVERT_CHUNK];
+    mlsize_t i = 0;
+    while (i < n) {
+        int filled = 0;
+        for (; i < n && filled < CONVERT_CHUNK; i++) {
+            chunk[filled++] = ml_to_int(Field(values, i));
+        }
+        add_values(c, chunk, filled);
+    }
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value mp_add_bigarray(value calc, value ba) {
+    CAMLparam2(calc, ba);
+    struct caml_ba_array* array = Caml_ba_array_val(ba);
+    if ((array->flags & CAML_BA_KIND_MASK) != CAML_BA_INT32 || array->num_dims != 1) {
+        caml_invalid_argument("MultiParadigmOCamlEngine.add_bigarray: expected a 1-D int32 Bigarray");
+    }
+    StatisticsCalculator* c = Calc_val(calc);
+    intnat n = array->dim[0];
+    if (n > INT_MAX - c->count) {
+        caml_invalid_argument("MultiParadigmOCamlEngine.add_bigarray: too many values");
+    }
+    add_values(c, (const int*)array->data, (int)n);
+    CAMLreturn(Val_unit);
+}
+
+CAMLprim value mp_clear_data(value calc) {
+    clear_data(Calc_val(calc));
+    return Val_unit;
+}
+
+CAMLprim value mp_count(value calc) {
+    return Val_int(Calc_val(calc)->count);
+}
+
+CAMLprim value mp_calculate_mean(value calc) {
+    return caml_copy_double(calculate_mean(Calc_val(calc)));
+}
+
+CAMLprim value mp_calculate_median(value calc) {
+    return caml_copy_double(calculate_median_double(Calc_val(calc)));
+}
+
+CAMLprim value mp_calculate_mode(value calc) {
+    CAMLparam1(calc);
+    CAMLlocal1(result);
+    StatisticsCalculator* c = Calc_val(calc);
+    if (c->count == 0) {
+        printf("Error: Cannot calculate mode - data is empty\n");
+        CAMLreturn(Atom(0));
+    }
+    // Copy straight from the engine's mode cache, so there is no buffer to
+    // leak if the tuple allocation raises
+    if (require_statistics(c, CACHE_MODE) != 0) {
+        caml_raise_out_of_memory();
+    }
+    if (c->cache_mode_count == 0) {
+        CAMLreturn(Atom(0));
+    }
+    result = caml_alloc_tuple((mlsize_t)c->cache_mode_count);
+    for (int i = 0; i < c->cache_mode_count; i++) {
+        Store_field(result, i, Val_int(c->cache_mode[i]));
+    }
+    CAMLreturn(result);
+}
+
+CAMLprim value mp_calculate_std_dev(value calc, value population) {
+    return caml_copy_double(calculate_std_dev(Calc_val(calc), Bool_val(population)));
+}
+
+CAMLprim value mp_calculate_range(value calc) {
+    return Val_int(calculate_range(Calc_val(calc)));
+}
+
+CAMLprim value mp_print_summary(value calc) {
+    print_summary(Calc_val(calc));
+    fflush(stdout);
+    return Val_unit;
+}
@@ -0,0 +1,450 @@
+/*
+ * Out-of-core statistics for integer files larger than RAM.
+ *
+ * The input (raw little-endian int32 or whitespace-separated text) is streamed
+ * in fixed-size chunks and never held in memory. Pass 1 keeps streaming
+ * aggregates for the moments (exact int64 sums per chunk merged with Chan's
+ * update for the variance), min/max, and a histogram of the high 16 bits of
+ * each value. Exact median and percentiles then come from multi-pass radix
+ * bucket selection: every later pass builds a low-16-bit histogram for the
+ * buckets that hold a target rank, which pins the value down exactly. Memory
+ * is bounded by the configured budget; when the low-level histograms for all
+ * target buckets don't fit at once, they are spread over extra passes.
+ *
+ * Build:
+ *   gcc -O2 MultiParadigmOutOfCore.c -o outofcore -lm
+ *   ./outofcore [--binary] [--budget MB] [--percentile P]... <file>
+ */
+
+#ifndef MULTIPARADIGM_OUT_OF_CORE_INCLUDED
+#define MULTIPARADIGM_OUT_OF_CORE_INCLUDED
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#define RADIX_BUCKETS 65536
+#define HISTOGRAM_BYTES (RADIX_BUCKETS * sizeof(uint64_t))
+#define MIN_MEMORY_BUDGET (4u << 20)
+#define DEFAULT_MEMORY_BUDGET (64u << 20)
+#define MAX_PERCENTILES 64
+
+typedef struct {
+    const char* path;
+    int binary;             // Raw int32 instead of text
+    size_t memory_budget;   // Upper bound on working memory in bytes
+} OutOfCoreConfig;
+
+typedef struct {
+    long long count;
+    int min;
+    int max;
+    double mean;
+    double m2;              // Sum of squared deviations from the mean
+    double median;
+    int percentile_count;
+    double percentiles[MAX_PERCENTILES];
+    double percentile_values[MAX_PERCENTILES];
+    int passes;             // Passes over the input, including pass 1
+} OutOfCoreResult;
+
+int analyze_out_of_core(const OutOfCoreConfig* config, const double percentiles[],
+                        int percentile_count, OutOfCoreResult* result);
+void print_out_of_core_summary(const OutOfCoreResult* result);
+
+// Order-preserving map from int to unsigned (high bit flipped)
+static uint32_t radix_key(int value) {
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+static int radix_value(uint32_t key) {
+    return (int)(key ^ 0x80000000u);
+}
+
+/* Chunked value stream over one pass of the file */
+typedef struct {
+    FILE* file;
+    int binary;
+    char* text;             // Raw text bytes, for text input
+    size_t text_capacity;
+    size_t text_length;
+    size_t text_pos;
+    int eof;
+} ValueStream;
+
+static int open_stream(ValueStream* stream, const OutOfCoreConfig* config, char* text,
+                       size_t text_capacity) {
+    stream->file = fopen(config->path, "rb");
+    if (stream->file == NULL) {
+        printf("Error: Cannot open %s\n", config->path);
+        return -1;
+    }
+    struct stat st;
+    if (config->binary && fstat(fileno(stream->file), &st) == 0 && st.st_size % (off_t)sizeof(int) != 0) {
+        printf("Error: %s is not a whole number of int32 values\n", config->path);
+        fclose(stream->file);
+        return -1;
+    }
+    stream->binary = config->binary;
+    stream->text = text;
+    stream->text_capacity = text_capacity;
+    stream->text_length = 0;
+    stream->text_pos = 0;
+    stream->eof = 0;
+    return 0;
+}
+
+static void close_stream(ValueStream* stream) {
+    fclose(stream->file);
+}
+
+// Fill `out` with up to `capacity` values; returns the count, 0 at the end, -1 on error
+static long read_chunk(ValueStream* stream, int* out, long capacity) {
+    if (stream->binary) {
+        size_t n = fread(out, sizeof(int), (size_t)capacity, stream->file);
+        if (n == 0 && ferror(stream->file)) {
+            printf("Error: Read failed\n");
+            return -1;
+        }
+        return (long)n;
+    }
+
+    long produced = 0;
+    while (produced < capacity) {
+        // Refill when the unread tail may hold a partial token
+        size_t remaining = stream->text_length - stream->text_pos;
+        if (!stream->eof && remaining < 24) {
+            memmove(stream->text, stream->text + stream->text_pos, remaining);
+            size_t n = fread(stream->text + remaining, 1, stream->text_capacity - remaining,
+                             stream->file);
+            stream->text_length = remaining + n;
+            stream->text_pos = 0;
+            if (n == 0) {
+                if (ferror(stream->file)) {
+                    printf("Error: Read failed\n");
+                    return -1;
+                }
+                stream->eof = 1;
+            }
+        }
+        const char* p = stream->text + stream->text_pos;
+        const char* end = stream->text + stream->text_length;
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r' || *p == ',')) {
+            p++;
+        }
+        if (p == end) {
+            stream->text_pos = stream->text_length;
+            if (stream->eof) {
+                break;
+            }
+            continue;
+        }
+        // A token touching the buffer end may continue in the next read
+        const char* token_end = p;
+        while (token_end < end && *token_end != ' ' && *token_end != '\n' && *token_end != '\t' &&
+               *token_end != '\r' && *token_end != ',') {
+            token_end++;
+        }
+        if (token_end == end && !stream->eof) {
+            stream->text_pos = (size_t)(p - stream->text);
+            size_t tail = stream->text_length - stream->text_pos;
+            if (tail >= stream->text_capacity / 2) {
+                printf("Error: Malformed token in input\n");
+                return -1;
+            }
+            memmove(stream->text, p, tail);
+            stream->text_length = tail;
+            stream->text_pos = 0;
+            size_t n = fread(stream->text + tail, 1, stream->text_capacity - tail, stream->file);
+            stream->text_length += n;
+            if (n == 0) {
+                stream->eof = 1;
+            }
+            continue;
+        }
+        int negative = *p == '-';
+        const char* digit = p + (negative || *p == '+');
+        long long value = 0;
+        if (digit == token_end) {
+            printf("Error: Malformed token in input\n");
+            return -1;
+        }
+        for (; digit < token_end; digit++) {
+            if (*digit < '0' || *digit > '9' || value > (long long)INT_MAX + 1) {
+                printf("Error: Malformed token in input\n");
+                return -1;
+            }
+            value = value * 10 + (*digit - '0');
+        }
+        value = negative ? -value : value;
+        if (value < INT_MIN || value > INT_MAX) {
+            printf("Error: Value out of int range in input\n");
+            return -1;
+        }
+        out[produced++] = (int)value;
+        stream->text_pos = (size_t)(token_end - stream->text);
+    }
+    return produced;
+}
+
+typedef struct {
+    long long rank;         // 0-based rank in sorted order
+    uint32_t bucket;        // High 16 bits of its radix key
+    long long bucket_rank;  // Rank within the bucket
+    int value;
+} RankTarget;
+
+// Pass 1: moments, min/max and the high-16-bit histogram
+static int first_pass(const OutOfCoreConfig* config, int* chunk, long chunk_capacity, char* text,
+                      size_t text_capacity, uint64_t* histogram, OutOfCoreResult* result) {
+    ValueStream stream;
+    if (open_stream(&stream, config, text, text_capacity) != 0) {
+        return -1;
+    }
+    long n;
+    result->count = 0;
+    result->mean = 0.0;
+    result->m2 = 0.0;
+    result->min = INT_MAX;
+    result->max = INT_MIN;
+    while ((n = read_chunk(&stream, chunk, chunk_capacity)) > 0) {
+        long long sum = 0;
+        for (long i = 0; i < n; i++) {
+            int v = chunk[i];
+            sum += v;
+            if (v < result->min) result->min = v;
+            if (v > result->max) result->max = v;
+            histogram[radix_key(v) >> 16]++;
+        }
+        double chunk_mean = (double)sum / n;
+        double chunk_m2 = 0.0;
+        for (long i = 0; i < n; i++) {
+            double d = chunk[i] - chunk_mean;
+            chunk_m2 += d * d;
+        }
+        // Chan et al. pairwise update of (count, mean, M2)
+        long long total = result->count + n;
+        double delta = chunk_mean - result->mean;
+        result->mean += delta * n / total;
+        result->m2 += chunk_m2 + delta * delta * ((double)result->count * n / total);
+        result->count = total;
+    }
+    close_stream(&stream);
+    return n < 0 ? -1 : 0;
+}
+
+// Later passes: low-16-bit histograms for `bucket_count` high buckets at once
+static int refine_pass(const OutOfCoreConfig* config, int* chunk, long chunk_capacity, char* text,
+                       size_t text_capacity, const uint32_t* buckets, int bucket_count,
+                       uint16_t* slots, uint64_t* histograms) {
+    ValueStream stream;
+    if (open_stream(&stream, config, text, text_capacity) != 0) {
+        return -1;
+    }
+    // slots[high] is 1 + the histogram index for a target bucket, 0 otherwise
+    memset(slots, 0, RADIX_BUCKETS * sizeof(uint16_t));
+    for (int b = 0; b < bucket_count; b++) {
+        slots[buckets[b]] = (uint16_t)(b + 1);
+    }
+    memset(histograms, 0, (size_t)bucket_count * HISTOGRAM_BYTES);
+    long n;
+    while ((n = read_chunk(&stream, chunk, chunk_capacity)) > 0) {
+        for (long i = 0; i < n; i++) {
+            uint32_t key = radix_key(chunk[i]);
+            uint16_t slot = slots[key >> 16];
+            if (slot != 0) {
+                histograms[(size_t)(slot - 1) * RADIX_BUCKETS + (key & 0xffff)]++;
+            }
+        }
+    }
+    close_stream(&stream);
+    return n < 0 ? -1 : 0;
+}
+
+static double interpolate(const RankTarget* targets, int lo, int hi, double fraction) {
+    return targets[lo].value + (targets[hi].value - (double)targets[lo].value) * fraction;
+}
+
+int analyze_out_of_core(const OutOfCoreConfig* config, const double percentiles[],
+                        int percentile_count, OutOfCoreResult* result) {
+    if (config->memory_budget < MIN_MEMORY_BUDGET) {
+        printf("Error: Memory budget must be at least %u MB\n", MIN_MEMORY_BUDGET >> 20);
+        return -1;
+    }
+    if (percentile_count < 0 || percentile_count > MAX_PERCENTILES) {
+        printf("Error: At most %d percentiles per run\n", MAX_PERCENTILES);
+        return -1;
+    }
+    memset(result, 0, sizeof(*result));
+
+    // Budget: a quarter each for the value chunk and the text buffer,
+    // the rest for histograms (one for pass 1, several for refinement)
+    size_t chunk_bytes = config->memory_budget / 4;
+    size_t text_bytes = config->binary ? 0 : config->memory_budget / 4;
+    size_t slots_bytes = RADIX_BUCKETS * sizeof(uint16_t);
+    size_t histogram_budget = config->memory_budget - chunk_bytes - text_bytes - slots_bytes;
+    long chunk_capacity = (long)(chunk_bytes / sizeof(int));
+    int histograms_per_pass = (int)(histogram_budget / HISTOGRAM_BYTES);
+
+    int* chunk = (int*)malloc(chunk_bytes);
+    char* text = text_bytes > 0 ? (char*)malloc(text_bytes) : NULL;
+    uint16_t* slots = (uint16_t*)malloc(slots_bytes);
+    uint64_t* histograms = (uint64_t*)calloc((size_t)histograms_per_pass, HISTOGRAM_BYTES);
+    if (chunk == NULL || (text_bytes > 0 && text == NULL) || slots == NULL || histograms == NULL) {
+        printf("Memory allocation failed\n");
+        free(chunk);
+        free(text);
+        free(slots);
+        free(histograms);
+        return -1;
+    }
+
+    int status = first_pass(config, chunk, chunk_capacity, text, text_bytes, histograms, result);
+    result->passes = 1;
+    if (status == 0 && result->count == 0) {
+        printf("Error: Cannot calculate statistics - data is empty\n");
+        status = -1;
+    }
+
+    // Each quantile needs the two ranks around its interpolation point
+    RankTarget targets[2 * (MAX_PERCENTILES + 1)];
+    int target_count = 0;
+    if (status == 0) {
+        result->percentile_count = percentile_count;
+        for (int i = 0; i <= percentile_count; i++) {
+            double p = i < percentile_count ? percentiles[i] : 50.0;
+            double h = (result->count - 1) * (p / 100.0);
+            targets[target_count++].rank = (long long)floor(h);
+            targets[target_count++].rank = (long long)ceil(h);
+        }
+        // Locate each rank's high bucket from the pass-1 histogram
+        for (int t = 0; t < target_count; t++) {
+            long long seen = 0;
+            uint32_t b = 0;
+            while (seen + (long long)histograms[b] <= targets[t].rank) {
+                seen += (long long)histograms[b++];
+            }
+            targets[t].bucket = b;
+            targets[t].bucket_rank = targets[t].rank - seen;
+        }
+    }
+
+    // Refinement passes over the distinct target buckets, bounded by the budget
+    uint32_t distinct[2 * (MAX_PERCENTILES + 1)];
+    int distinct_count = 0;
+    for (int t = 0; status == 0 && t < target_count; t++) {
+        int known = 0;
+        for (int d = 0; d < distinct_count; d++) {
+            known |= distinct[d] == targets[t].bucket;
+        }
+        if (!known) {
+            distinct[distinct_count++] = targets[t].bucket;
+        }
+    }
+    for (int start = 0; status == 0 && start < distinct_count; start += histograms_per_pass) {
+        int group = distinct_count - start < histograms_per_pass ? distinct_count - start
+                                                                 : histograms_per_pass;
+        status = refine_pass(config, chunk, chunk_capacity, text, text_bytes, distinct + start,
+                             group, slots, histograms);
+        result->passes++;
+        for (int t = 0; status == 0 && t < target_count; t++) {
+            for (int g = 0; g < group; g++) {
+                if (distinct[start + g] != targets[t].bucket) {
+                    continue;
+                }
+                const uint64_t* low = histograms + (size_t)g * RADIX_BUCKETS;
+                long long seen = 0;
+                uint32_t l = 0;
+                while (seen + (long long)low[l] <= targets[t].bucket_rank) {
+                    seen += (long long)low[l++];
+                }
+                targets[t].value = radix_value((targets[t].bucket << 16) | l);
+            }
+        }
+    }
+
+    if (status == 0) {
+        for (int i = 0; i <= percentile_count; i++) {
+            double p = i < percentile_count ? percentiles[i] : 50.0;
+            double h = (result->count - 1) * (p / 100.0);
+            double value = interpolate(targets, 2 * i, 2 * i + 1, h - floor(h));
+            if (i < percentile_count) {
+                result->percentiles[i] = p;
+                result->percentile_values[i] = value;
+            } else {
+                result->median = value;
+            }
+        }
+    }
+    free(chunk);
+    free(text);
+    free(slots);
+    free(histograms);
+    return status;
+}
+
+void print_out_of_core_summary(const OutOfCoreResult* result) {
+    printf("Statistics Calculator Summary (out-of-core, %d passes):\n", result->passes);
+    printf("Data Points: %lld\n", result->count);
+    printf("Min: %d, Max: %d, Range: %lld\n", result->min, result->max,
+           (long long)result->max - result->min);
+    printf("Mean: %.4f\n", result->mean);
+    printf("Median: %.1f\n", result->median);
+    for (int i = 0; i < result->percentile_count; i++) {
+        printf("P%g: %.4f\n", result->percentiles[i], result->percentile_values[i]);
+    }
+    if (result->count >= 2) {
+        printf("Sample Std Dev: %.4f\n", sqrt(result->m2 / (result->count - 1)));
+    } else {
+        printf("Sample Std Dev: N/A\n");
+    }
+    printf("Population Std Dev: %.4f\n", sqrt(result->m2 / result->count));
+}
+
+#ifndef OUT_OF_CORE_NO_MAIN
+int main(int argc, char** argv) {
+    OutOfCoreConfig config = {NULL, 0, DEFAULT_MEMORY_BUDGET};
+    double percentiles[MAX_PERCENTILES];
+    int percentile_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binary") == 0) {
+            config.binary = 1;
+        } else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            config.memory_budget = (size_t)strtoull(argv[++i], NULL, 10) << 20;
+        } else if (strcmp(argv[i], "--percentile") == 0 && i + 1 < argc &&
+                   percentile_count < MAX_PERCENTILES) {
+            double p = strtod(argv[++i], NULL);
+            if (p < 0.0 || p > 100.0) {
+                printf("Error: Percentile must be between 0 and 100\n");
+                return 1;
+            }
+            percentiles[percentile_count++] = p;
+        } else if (config.path == NULL && argv[i][0] != '-') {
+            config.path = argv[i];
+        } else {
+            config.path = NULL;
+            break;
+        }
+    }
+    if (config.path == NULL) {
+        printf("Usage: %s [--binary] [--budget MB] [--percentile P]... <file>\n", argv[0]);
+        return 1;
+    }
+    OutOfCoreResult result;
+    if (analyze_out_of_core(&config, percentiles, percentile_count, &result) != 0) {
+        return 1;
+    }
+    print_out_of_core_summary(&result);
+    return 0;
+}
+#endif /* OUT_OF_CORE_NO_MAIN */
+
+#endif /* MULTIPARADIGM_OUT_OF_CORE_INCLUDED */
@@ -0,0 +1,547 @@
+/*
+ * CPython binding for the C StatisticsCalculator (module `statscalc`).
+ *
+ * Exposes the same API as the StatisticsCalculator class in
+ * MultiParadigmPython.py, backed by the C engine in MultiParadigmC.c.
+ * add_values() accepts any object supporting the buffer protocol (array,
+ * NumPy arrays, memoryview, ...) and reads it in place; C-contiguous int32
+ * buffers are handed straight to the engine without an intermediate copy.
+ *
+ * Build:
+ *   gcc -O2 -shared -fPIC $(python3-config --includes) MultiParadigmPyExt.c \
+ *       -o statscalc$(python3-config --extension-suffix) -lm
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define STATS_NO_MAIN
+#include "MultiParadigmC.c"
+
+#define CONVERT_CHUNK 1024
+
+typedef struct {
+    PyObject_HEAD
+    StatisticsCalculator* calc;
+} StatsObject;
+
+// Convert a Python int to a C int, raising OverflowError outside int32
+static int py_to_int(PyObject* obj, int* out) {
+    long value = PyLong_AsLong(obj);
+    if (value == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    if (value < INT_MIN || value > INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "value does not fit in a C int");
+        return -1;
+    }
+    *out = (int)value;
+    return 0;
+}
+
+static int require_data(StatsObject* self, const char* what) {
+    if (self->calc->count == 0) {
+        PyErr_Format(PyExc_ValueError, "Cannot calculate %s: data is empty", what);
+        return -1;
+    }
+    return 0;
+}
+
+// Read one element of a buffer with struct-module format `fmt` as a C int
+static int buffer_item_to_int(const char* p, char fmt, int* out) {
+    long long value;
+    switch (fmt) {
+        case 'b': value = *(const signed char*)p; break;
+        case 'B': value = *(const unsigned char*)p; break;
+        case 'h': value = *(const short*)p; break;
+        case 'H': value = *(const unsigned short*)p; break;
+        case 'i': value = *(const int*)p; break;
+        case 'I': value = *(const unsigned int*)p; break;
+        case 'l': value = *(const long*)p; break;
+        case 'L': {
+            unsigned long u = *(const unsigned long*)p;
+            value = u > (unsigned long)INT_MAX ? (long long)INT_MAX + 1 : (long long)u;
+            break;
+        }
+        case 'q': value = *(const long long*)p; break;
+        case 'Q': {
+            unsigned long long u = *(const unsigned long long*)p;
+            value = u > (unsigned long long)INT_MAX ? (long long)INT_MAX + 1 : (long long)u;
+            break;
+        }
+        case 'n': value = *(const Py_ssize_t*)p; break;
+        case 'N': {
+            size_t u = *(const size_t*)p;
+            value = u > (size_t)INT_MAX ? (long long)INT_MAX + 1 : (long long)u;
+            break;
+        }
+        default:
+            PyErr_Format(PyExc_TypeError, "unsupported buffer format '%c'", fmt);
+            return -1;
+    }
+    if (value < INT_MIN || value > INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "value does not fit in a C int");
+        return -1;
+    }
+    *out = (int)value;
+    return 0;
+}
+
+static int add_from_buffer(StatisticsCalculator* calc, PyObject* obj) {
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_FORMAT | PyBUF_STRIDES) != 0) {
+        return -1;
+    }
+    int status = -1;
+    const char* format = view.format != NULL ? view.format : "B";
+    if (*format == '@' || *format == '=' || *format == '<') {
+        format++;  // Native and little-endian standard sizes match on supported hosts
+    }
+    if (view.ndim > 1 || format[0] == '\0' || format[1] != '\0') {
+        PyErr_SetString(PyExc_TypeError, "add_values() expects a 1-D buffer of integers");
+        goto done;
+    }
+    Py_ssize_t n = view.ndim == 0 ? 1 : view.shape[0];
+    Py_ssize_t stride = view.ndim == 0 ? view.itemsize : view.strides[0];
+    if (n > INT_MAX - calc->count) {
+        PyErr_SetString(PyExc_OverflowError, "too many values for one calculator");
+        goto done;
+    }
+
+    char fmt = format[0];
+    int is_int32 = (fmt == 'i' || fmt == 'l') && view.itemsize == (Py_ssize_t)sizeof(int);
+    if (is_int32 && stride == view.itemsize) {
+        // Layout already matches the engine: no conversion, no temporary
+        add_values(calc, (const int*)view.buf, (int)n);
+        status = 0;
+        goto done;
+    }
+
+    if (reserve_capacity(calc, calc->count + (int)n) != 0) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    int chunk[CONVERT_CHUNK];
+    Py_ssize_t i = 0;
+    while (i < n) {
+        int filled = 0;
+        for (; i < n && filled < CONVERT_CHUNK; i++) {
+            const char* item = (const char*)view.buf + i * stride;
+            if (buffer_item_to_int(item, fmt, &chunk[filled++]) != 0) {
+                goto done;
+            }
+        }
+        add_values(calc, chunk, filled);
+    }
+    status = 0;
+
+done:
+    PyBuffer_Release(&view);
+    return status;
+}
+
+static int add_from_iterable(StatisticsCalculator* calc, PyObject* obj) {
+    PyObject* seq = PySequence_Fast(obj, "add_values() expects a buffer or an iterable of ints");
+    if (seq == NULL) {
+        return -1;
+    }
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    PyObject** items = PySequence_Fast_ITEMS(seq);
+    if (n > INT_MAX - calc->count || reserve_capacity(calc, calc->count + (int)n) != 0) {
+        Py_DECREF(seq);
+        PyErr_NoMemory();
+        return -1;
+    }
+    int chunk[CONVERT_CHUNK];
+    Py_ssize_t i = 0;
+    while (i < n) {
+        int filled = 0;
+        for (; i < n && filled < CONVERT_CHUNK; i++) {
+            if (py_to_int(items[i], &chunk[filled++]) != 0) {
+                Py_DECREF(seq);
+                return -1;
+            }
+        }
+        add_values(calc, chunk, filled);
+    }
+    Py_DECREF(seq);
+    return 0;
+}
+
+// Add from a buffer or iterable; on failure the calculator is left unchanged
+static int add_any(StatisticsCalculator* calc, PyObject* values) {
+    int old_count = calc->count;
+    int status = PyObject_CheckBuffer(values) ? add_from_buffer(calc, values)
+                                              : add_from_iterable(calc, values);
+    if (status != 0 && calc->count != old_count) {
+        calc->count = old_count;
+        invalidate_cache(calc, CACHE_VALUES, 0);
+    }
+    return status;
+}
+
+static PyObject* Stats_new(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+    (void)args;
+    (void)kwds;
+    StatsObject* self = (StatsObject*)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->calc = create_calculator();
+    if (self->calc == NULL) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return (PyObject*)self;
+}
+
+static int Stats_init(StatsObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"data", NULL};
+    PyObject* data = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &data)) {
+        return -1;
+    }
+    clear_data(self->calc);
+    if (data != Py_None) {
+        return add_any(self->calc, data);
+    }
+    return 0;
+}
+
+static void Stats_dealloc(StatsObject* self) {
+    free_calculator(self->calc);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject* Stats_get_data(StatsObject* self, void* closure) {
+    (void)closure;
+    PyObject* list = PyList_New(self->calc->count);
+    if (list == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < self->calc->count; i++) {
+        PyObject* item = PyLong_FromLong(self->calc->data[i]);
+        if (item == NULL) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    return list;
+}
+
+static PyObject* Stats_get_version(StatsObject* self, void* closure) {
+    (void)closure;
+    return PyLong_FromUnsignedLongLong(calculator_version(self->calc));
+}
+
+static int Stats_set_data(StatsObject* self, PyObject* value, void* closure) {
+    (void)closure;
+    if (value == NULL) {
+        PyErr_SetString(PyExc_AttributeError, "cannot delete data");
+        return -1;
+    }
+    clear_data(self->calc);
+    return add_any(self->calc, value);
+}
+
+static PyObject* Stats_add_value(StatsObject* self, PyObject* arg) {
+    int value;
+    if (py_to_int(arg, &value) != 0) {
+        return NULL;
+    }
+    add_value(self->calc, value);
+    Py_RETURN_NONE;
+}
+
+static PyObject* Stats_add_values(StatsObject* self, PyObject* arg) {
+    if (add_any(self->calc, arg) != 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* Stats_clear_data(StatsObject* self, PyObject* unused) {
+    (void)unused;
+    clear_data(self->calc);
+    Py_RETURN_NONE;
+}
+
+static PyObject* Stats_mean(StatsObject* self, PyObject* unused) {
+    (void)unused;
+    if (require_data(self, "mean") != 0) {
+        return NULL;
+    }
+    return PyFloat_FromDouble(calculate_mean(self->calc));
+}
+
+static PyObject* Stats_median(StatsObject* self, PyObject* unused) {
+    (void)unused;
+    if (require_data(self, "median") != 0) {
+        return NULL;
+    }
+    return PyFloat_FromDouble(calculate_median_double(self->calc));
+}
+
+static PyObject* mode_list(StatisticsCalculator* calc) {
+    int* modes = (int*)PyMem_Malloc((size_t)calc->count * sizeof(int));
+    if (modes == NULL) {
+        return PyErr_NoMemory();
+    }
+    int mode_count = 0;
+    calculate_mode(calc, modes, &mode_count);
+    PyObject* list = PyList_New(mode_count);
+    for (int i = 0; list != NULL && i < mode_count; i++) {
+        PyObject* item = PyLong_FromLong(modes[i]);
+        if (item == NULL) {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    PyMem_Free(modes);
+    return list;
+}
+
+static PyObject* Stats_mode(StatsObject* self, PyObject* unused) {
+    (void)unused;
+    if (require_data(self, "mode") != 0) {
+        return NULL;
+    }
+    return mode_list(self->calc);
+}
+
+static PyObject* Stats_top_k(StatsObject* self, PyObject* arg) {
+    long k = PyLong_AsLong(arg);
+    if (k == -1 && PyErr_Occurred()) {
+        return NULL;
+    }
+    if (k <= 0) {
+        PyErr_SetString(PyExc_ValueError, "k must be positive");
+        return NULL;
+    }
+    if (require_data(self, "top_k") != 0) {
+        return NULL;
+    }
+    StatisticsCalculator* calc = self->calc;
+    int limit = k < calc->count ? (int)k : calc->count;
+    int* values = (int*)PyMem_Malloc((size_t)limit * sizeof(int));
+    int* counts = (int*)PyMem_Malloc((size_t)limit * sizeof(int));
+    int found = values != NULL && counts != NULL ? calculate_top_k(calc, limit, values, counts) : -1;
+    PyObject* list = found >= 0 ? PyList_New(found) : PyErr_NoMemory();
+    for (int i = 0; list != NULL && i < found; i++) {
+        PyObject* item = Py_BuildValue("(ii)", values[i], counts[i]);
+        if (item == NULL) {
+            Py_CLEAR(list);
+            break;
+        }
+        PyList_SET_ITEM(list, i, item);
+    }
+    PyMem_Free(values);
+    PyMem_Free(counts);
+    return list;
+}
+
+static PyObject* std_dev(StatsObject* self, int population) {
+    if (self->calc->count == 0) {
+        PyErr_SetString(PyExc_ValueError, "Cannot calculate standard deviation: data is empty");
+        return NULL;
+    }
+    if (!population && self->calc->count < 2) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Cannot calculate sample standard deviation with less than 2 data points");
+        return NULL;
+    }
+    return PyFloat_FromDouble(calculate_std_dev(self->calc, population));
+}
+
+static PyObject* Stats_standard_deviation(StatsObject* self, PyObject* args, PyObject* kwds) {
+    static char* kwlist[] = {"population", NULL};
+    int population = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", kwlist, &population)) {
+        return NULL;
+    }
+    return std_dev(self, population);
+}
+
+static PyObject* Stats_range(StatsObject* self, PyObject* unused) {
+    (void)unused;
+    if (require_data(self, "range") != 0) {
+        return NULL;
+    }
+    return PyLong_FromLong(calculate_range(self->calc));
+}
+
+// Store `value` under `key`, mapping a ValueError to None like the Python class
+static int set_stat(PyObject* dict, const char* key, PyObject* value) {
+    if (value == NULL) {
+        if (!PyErr_ExceptionMatches(PyExc_ValueError)) {
+            return -1;
+        }
+        PyErr_Clear();
+        value = Py_NewRef(Py_None);
+    }
+    int status = PyDict_SetItemString(dict, key, value);
+    Py_DECREF(value);
+    return status;
+}
+
+static PyObject* Stats_summary(StatsObject* self, PyObject* unused) {
+    (void)unused;
+    StatisticsCalculator* calc = self->calc;
+    PyObject* dict = PyDict_New();
+    if (dict == NULL) {
+        return NULL;
+    }
+    if (set_stat(dict, "mean", Stats_mean(self, NULL)) != 0 ||
+        set_stat(dict, "median", Stats_median(self, NULL)) != 0 ||
+        set_stat(dict, "mode", Stats_mode(self, NULL)) != 0 ||
+        set_stat(dict, "std_dev_sample", std_dev(self, 0)) != 0 ||
+        set_stat(dict, "std_dev_population", std_dev(self, 1)) != 0 ||
+        set_stat(dict, "range", Stats_range(self, NULL)) != 0 ||
+        set_stat(dict, "count", PyLong_FromLong(calc->count)) != 0) {
+        Py_DECREF(dict);
+        return NULL;
+    }
+    PyObject* min_value = Py_NewRef(Py_None);
+    PyObject* max_value = Py_NewRef(Py_None);
+    if (calc->count > 0) {
+        require_statistics(calc, CACHE_MIN | CACHE_MAX);
+        Py_SETREF(min_value, PyLong_FromLong(calc->cache_min));
+        Py_SETREF(max_value, PyLong_FromLong(calc->cache_max));
+    }
+    if (set_stat(dict, "min", min_value) != 0 || set_stat(dict, "max", max_value) != 0) {
+        Py_DECREF(dict);
+        return NULL;
+    }
+    return dict;
+}
+
+static PyObject* Stats_summary_json(StatsObject* self, PyObject* unused) {
+    (void)unused;
+    char stack[1024];
+    size_t length = summary_to_json(self->calc, stack, sizeof(stack));
+    if (length < sizeof(stack)) {
+        return PyUnicode_FromStringAndSize(stack, (Py_ssize_t)length);
+    }
+    char* buffer = (char*)PyMem_Malloc(length + 1);
+    if (buffer == NULL) {
+        return PyErr_NoMemory();
+    }
+    summary_to_json(self->calc, buffer, length + 1);
+    PyObject* result = PyUnicode_FromStringAndSize(buffer, (Py_ssize_t)length);
+    PyMem_Free(buffer);
+    return result;
+}
+
+static PyObject* Stats_summary_record(StatsObject* self, PyObject* unused) {
+    (void)unused;
+    size_t size = summary_to_binary(self->calc, NULL, 0);
+    PyObject* result = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)size);
+    if (result != NULL) {
+        summary_to_binary(self->calc, PyBytes_AS_STRING(result), size);
+    }
+    return result;
+}
+
+static PyObject* Stats_str(StatsObject* self) {
+    StatisticsCalculator* calc = self->calc;
+    if (calc->count == 0) {
+        return PyUnicode_FromString("StatisticsCalculator: No data available");
+    }
+    require_statistics(calc, CACHE_MIN | CACHE_MAX);
+    char* median = PyOS_double_to_string(calculate_median_double(calc), 'r', 0, Py_DTSF_ADD_DOT_0, NULL);
+    PyObject* modes = mode_list(calc);
+    PyObject* modes_repr = modes != NULL ? PyObject_Repr(modes) : NULL;
+    Py_XDECREF(modes);
+    if (median == NULL || modes_repr == NULL) {
+        PyMem_Free(median);
+        Py_XDECREF(modes_repr);
+        return NULL;
+    }
+
+    char sample[64];
+    char population[64];
+    if (calc->count >= 2) {
+        snprintf(sample, sizeof(sample), "Sample Std Dev: %.4f", calculate_std_dev(calc, 0));
+    } else {
+        snprintf(sample, sizeof(sample), "Sample Std Dev: N/A");
+    }
+    snprintf(population, sizeof(population), "Population Std Dev: %.4f", calculate_std_dev(calc, 1));
+    char header[256];
+    snprintf(header, sizeof(header),
+             "Statistics Calculator Summary:\nData Points: %d\nMin: %d, Max: %d, Range: %d\nMean: %.4f\n",
+             calc->count, calc->cache_min, calc->cache_max,
+             calculate_range(calc), calculate_mean(calc));
+
+    PyObject* result = PyUnicode_FromFormat("%sMedian: %s\nMode(s): %U\n%s\n%s",
+                                            header, median, modes_repr, sample, population);
+    PyMem_Free(median);
+    Py_DECREF(modes_repr);
+    return result;
+}
+
+static PyMethodDef Stats_methods[] = {
+    {"add_value", (PyCFunction)Stats_add_value, METH_O, "Add a single value to the data."},
+    {"add_values", (PyCFunction)Stats_add_values, METH_O,
+     "Add multiple values; buffer-protocol objects are read in place."},
+    {"clear_data", (PyCFunction)Stats_clear_data, METH_NOARGS, "Clear all data and cached results."},
+    {"mean", (PyCFunction)Stats_mean, METH_NOARGS, "Calculate the mean (average) of the data."},
+    {"median", (PyCFunction)Stats_median, METH_NOARGS, "Calculate the median of the data."},
+    {"mode", (PyCFunction)Stats_mode, METH_NOARGS, "Calculate the mode(s) of the data."},
+    {"top_k", (PyCFunction)Stats_top_k, METH_O,
+     "The k most frequent values as (value, count) pairs, most frequent first."},
+    {"standard_deviation", (PyCFunction)(void (*)(void))Stats_standard_deviation,
+     METH_VARARGS | METH_KEYWORDS, "Calculate the sample or population standard deviation."},
+    {"range", (PyCFunction)Stats_range, METH_NOARGS, "Calculate the range of the data (max - min)."},
+    {"summary", (PyCFunction)Stats_summary, METH_NOARGS, "Generate a summary of all statistics."},
+    {"summary_json", (PyCFunction)Stats_summary_json, METH_NOARGS,
+     "The summary as a JSON string, with shortest round-trip floats."},
+    {"summary_record", (PyCFunction)Stats_summary_record, METH_NOARGS,
+     "The summary as a packed binary record followed by the int32 modes."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef Stats_getset[] = {
+    {"data", (getter)Stats_get_data, (setter)Stats_set_data,
+     "The current data as a list; assigning replaces it and clears cached results.", NULL},
+    {"version", (getter)Stats_get_version, NULL,
+     "Data version; it changes whenever the data does, so results keyed on it can be reused.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyTypeObject StatsType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "statscalc.StatisticsCalculator",
+    .tp_doc = "A class for calculating basic statistics on a list of integers (C engine).",
+    .tp_basicsize = sizeof(StatsObject),
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = Stats_new,
+    .tp_init = (initproc)Stats_init,
+    .tp_dealloc = (destructor)Stats_dealloc,
+    .tp_str = (reprfunc)Stats_str,
+    .tp_methods = Stats_methods,
+    .tp_getset = Stats_getset,
+};
+
+static struct PyModuleDef statscalc_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "statscalc",
+    .m_doc = "C-engine StatisticsCalculator with the MultiParadigmPython API.",
+    .m_size = -1,
+};
+
+PyMODINIT_FUNC PyInit_statscalc(void) {
+    if (PyType_Ready(&StatsType) < 0) {
+        return NULL;
+    }
+    PyObject* module = PyModule_Create(&statscalc_module);
+    if (module == NULL) {
+        return NULL;
+    }
+    if (PyModule_AddObjectRef(module, "StatisticsCalculator", (PyObject*)&StatsType) < 0) {
+        Py_DECREF(module);
+        return NULL;
+    }
+    return module;
+}
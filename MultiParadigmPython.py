@@ -1,6 +1,9 @@
 from collections import Counter
 from typing import List, Union, Dict, Optional
 import math
+import resource
+import sys
+import time
 
 
 class StatisticsCalculator:
@@ -115,17 +118,22 @@ class StatisticsCalculator:
         if not population and n < 2:
             raise ValueError("Cannot calculate sample standard deviation with less than 2 data points")
         
-        mean_val = self.mean()
-        variance = sum((x - mean_val) ** 2 for x in self._data) / (n if population else n - 1)
-        return math.sqrt(variance)
+        key = 'std_dev_population' if population else 'std_dev_sample'
+        if key not in self._cache:
+            mean_val = self.mean()
+            variance = sum((x - mean_val) ** 2 for x in self._data) / (n if population else n - 1)
+            self._cache[key] = math.sqrt(variance)
+        return self._cache[key]
     
     def range(self) -> int:
         """Calculate the range of the data (max - min)."""
-        if not self._data:
-            raise ValueError("Cannot calculate range: data is empty")
-        
-        sorted_data = self._get_sorted_data()
-        return sorted_data[-1] - sorted_data[0]
+        if 'range' not in self._cache:
+            if not self._data:
+                raise ValueError("Cannot calculate range: data is empty")
+            
+            sorted_data = self._get_sorted_data()
+            self._cache['range'] = sorted_data[-1] - sorted_data[0]
+        return self._cache['range']
     
     def summary(self) -> Dict[str, Union[float, List[int]]]:
         """Generate a summary of all statistics."""
@@ -197,6 +205,14 @@ class StatisticsCalculator:
             return f"StatisticsCalculator: Error generating statistics - {e}"
 
 
+# The C engine binding (built from MultiParadigmPyExt.c) exposes the same API;
+# fall back to the pure-Python class when the extension is not available.
+try:
+    from statscalc import StatisticsCalculator as FastStatisticsCalculator
+except ImportError:
+    FastStatisticsCalculator = StatisticsCalculator
+
+
 # Example usage and demonstration
 def demonstrate_statistics_calculator():
     """Demonstrate the usage of the StatisticsCalculator class."""
@@ -296,5 +312,57 @@ def demonstrate_statistics_calculator():
         print("No significant outliers found.")
 
 
+def _peak_rss_kb() -> int:
+    """Peak resident set size; VmHWM excludes the parent's footprint inherited at fork."""
+    try:
+        with open("/proc/self/status") as status:
+            for line in status:
+                if line.startswith("VmHWM:"):
+                    return int(line.split()[1])
+    except OSError:
+        pass
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+
+
+def run_benchmark(path: str, engine: str = "python") -> None:
+    """Time each operation on a fresh calculator for MultiParadigmBench.py.
+    
+    Prints one tab-separated line per operation: name, size, wall seconds,
+    peak RSS in KB and the result.
+    """
+    with open(path) as f:
+        values = [int(token) for token in f.read().split()]
+    calculator_class = FastStatisticsCalculator if engine == "c" else StatisticsCalculator
+    if engine == "c" and calculator_class is StatisticsCalculator:
+        raise SystemExit("statscalc extension is not built")
+    if engine == "c":
+        import array
+        values = array.array('i', values)  # Exercise the zero-copy buffer path
+    
+    operations = [
+        ("mean", lambda calc: calc.mean()),
+        ("median", lambda calc: calc.median()),
+        ("mode", lambda calc: ",".join(str(v) for v in calc.mode())),
+        ("std_dev_sample", lambda calc: calc.standard_deviation()),
+        ("std_dev_population", lambda calc: calc.standard_deviation(population=True)),
+        ("range", lambda calc: calc.range()),
+    ]
+    for name, operation in [("add_values", None)] + operations:
+        calculator = calculator_class()
+        start = time.perf_counter()
+        calculator.add_values(values)
+        elapsed = time.perf_counter() - start
+        result = len(values)
+        if operation is not None:
+            start = time.perf_counter()
+            result = operation(calculator)
+            elapsed = time.perf_counter() - start
+        peak_kb = _peak_rss_kb()
+        print(f"{name}\t{len(values)}\t{elapsed:.9f}\t{peak_kb}\t{result}")
+
+
 if __name__ == "__main__":
-    demonstrate_statistics_calculator()
+    if len(sys.argv) >= 3 and sys.argv[1] == "--bench":
+        run_benchmark(sys.argv[2], sys.argv[3] if len(sys.argv) > 3 else "python")
+    else:
+        demonstrate_statistics_calculator()
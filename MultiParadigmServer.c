@@ -0,0 +1,749 @@
+/*
+ * Local statistics server for the C StatisticsCalculator.
+ *
+ * Hosts named calculators behind a Unix stream socket, so several processes on
+ * one host can push samples into shared calculators and query them. A pool of
+ * worker threads waits on a single epoll instance; every socket is registered
+ * EPOLLONESHOT, so one worker at a time owns a connection and re-arms it when
+ * it has drained the input. Each calculator is guarded by its own mutex.
+ *
+ * Protocol (host byte order; lengths count the bytes after the length field,
+ * and every message is a multiple of 4 bytes long):
+ *   request  = u32 length | u8 op | u8 stat | u16 name_len | name, zero-padded
+ *              to 4 bytes | payload
+ *   response = u32 length | u8 status | u8 stat | u16 reserved | payload
+ *
+ *   OP_PUSH   payload int32 values[]           reply u64 total count
+ *   OP_QUERY  STAT_MEAN, STAT_MEDIAN            reply f64
+ *             STAT_PERCENTILE, payload f64 p    reply f64
+ *             STAT_SUMMARY                      reply StatsSummary
+ *   OP_CLEAR                                    reply empty
+ *
+ * PUSH creates the calculator on first use. Requests may be pipelined and are
+ * answered in order. With a metrics port, every calculator is also exposed for
+ * Prometheus at http://127.0.0.1:<port>/metrics (see MultiParadigmMetrics.c).
+ * At startup the engine's sort and median thresholds are loaded from the
+ * tuning file, or measured and saved there on first run (tune_thresholds()).
+ *
+ * Build:
+ *   gcc -O2 -pthread MultiParadigmServer.c -o mpserver -lm
+ *   ./mpserver --serve /tmp/stats.sock [workers] [metrics_port]
+ *   ./mpserver --loadgen /tmp/stats.sock [clients] [seconds] [batch]
+ */
+
+#ifndef MULTIPARADIGM_SERVER_INCLUDED
+#define MULTIPARADIGM_SERVER_INCLUDED
+
+#define STATS_NO_MAIN
+#include "MultiParadigmC.c"
+#define METRICS_NO_MAIN
+#include "MultiParadigmMetrics.c"
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define OP_PUSH  1
+#define OP_QUERY 2
+#define OP_CLEAR 3
+
+#define STAT_MEAN       1
+#define STAT_MEDIAN     2
+#define STAT_PERCENTILE 3
+#define STAT_SUMMARY    4
+
+#define STATUS_OK          0
+#define STATUS_NOT_FOUND   1
+#define STATUS_BAD_REQUEST 2
+#define STATUS_EMPTY       3
+#define STATUS_OVERFLOW    4
+
+#define SERVER_MAX_NAME 255
+#define SERVER_MAX_FRAME (16 << 20)
+#define SERVER_MAX_PENDING_OUTPUT (4 << 20)  // Stop reading until replies drain
+#define SERVER_READ_CHUNK 65536
+#define SERVER_BUCKETS 1024
+#define SERVER_EVENTS 4
+
+typedef struct {
+    uint64_t count;
+    int32_t min;
+    int32_t max;
+    double mean;
+    double median;
+    double std_dev_sample;       // 0 with fewer than two values
+    double std_dev_population;
+} StatsSummary;
+
+typedef struct NamedCalculator {
+    struct NamedCalculator* next;
+    pthread_mutex_t lock;
+    StatisticsCalculator* calc;
+    size_t name_len;
+    char name[];          // NUL-terminated
+} NamedCalculator;
+
+typedef struct {
+    int fd;
+    int listening;
+    unsigned char* in;
+    size_t in_len;
+    size_t in_cap;
+    unsigned char* out;
+    size_t out_len;
+    size_t out_pos;
+    size_t out_cap;
+} Connection;
+
+typedef struct {
+    int epoll_fd;
+    Connection listener;
+    pthread_mutex_t registry_lock;  // Guards the buckets; calculators are never removed
+    NamedCalculator* buckets[SERVER_BUCKETS];
+} StatsServer;
+
+static volatile sig_atomic_t server_stopping = 0;
+
+static uint32_t name_hash(const char* name, size_t len) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Find a calculator by name, creating it when `create` is set
+static NamedCalculator* find_calculator(StatsServer* server, const char* name, size_t len, int create) {
+    NamedCalculator** bucket = &server->buckets[name_hash(name, len) % SERVER_BUCKETS];
+    pthread_mutex_lock(&server->registry_lock);
+    NamedCalculator* entry = *bucket;
+    while (entry != NULL && (entry->name_len != len || memcmp(entry->name, name, len) != 0)) {
+        entry = entry->next;
+    }
+    if (entry == NULL && create) {
+        entry = (NamedCalculator*)malloc(sizeof(NamedCalculator) + len + 1);
+        if (entry != NULL) {
+            entry->calc = create_calculator();
+            if (entry->calc == NULL) {
+                free(entry);
+                entry = NULL;
+            } else {
+                pthread_mutex_init(&entry->lock, NULL);
+                entry->name_len = len;
+                memcpy(entry->name, name, len);
+                entry->name[len] = '\0';
+                entry->next = *bucket;
+                *bucket = entry;
+            }
+        }
+    }
+    pthread_mutex_unlock(&server->registry_lock);
+    return entry;
+}
+
+static int ensure_space(unsigned char** buffer, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) {
+        return 0;
+    }
+    size_t new_capacity = *capacity > 0 ? *capacity : SERVER_READ_CHUNK;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    unsigned char* grown = (unsigned char*)realloc(*buffer, new_capacity);
+    if (grown == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    *buffer = grown;
+    *capacity = new_capacity;
+    return 0;
+}
+
+static int append_reply(Connection* conn, int status, int stat, const void* payload, size_t size) {
+    uint32_t header[2];
+    header[0] = (uint32_t)(sizeof(uint32_t) + size);
+    unsigned char* tail = (unsigned char*)&header[1];
+    tail[0] = (unsigned char)status;
+    tail[1] = (unsigned char)stat;
+    tail[2] = tail[3] = 0;
+    if (ensure_space(&conn->out, &conn->out_cap, conn->out_len + sizeof(header) + size) != 0) {
+        return -1;
+    }
+    memcpy(conn->out + conn->out_len, header, sizeof(header));
+    if (size > 0) {
+        memcpy(conn->out + conn->out_len + sizeof(header), payload, size);
+    }
+    conn->out_len += sizeof(header) + size;
+    return 0;
+}
+
+static int reply_double(Connection* conn, int stat, double value) {
+    return append_reply(conn, STATUS_OK, stat, &value, sizeof(value));
+}
+
+static void fill_summary(StatisticsCalculator* calc, StatsSummary* summary) {
+    summary->count = (uint64_t)calc->count;
+    summary->mean = calculate_mean(calc);
+    summary->median = calculate_median_double(calc);
+    require_statistics(calc, CACHE_MIN | CACHE_MAX);
+    summary->min = calc->cache_min;
+    summary->max = calc->cache_max;
+    summary->std_dev_sample = calc->count > 1 ? calculate_std_dev(calc, 0) : 0.0;
+    summary->std_dev_population = calculate_std_dev(calc, 1);
+}
+
+static int handle_query(Connection* conn, NamedCalculator* entry, int stat,
+                        const unsigned char* payload, size_t size) {
+    double percentile = 0.0;
+    if (stat == STAT_PERCENTILE) {
+        if (size != sizeof(double)) {
+            return append_reply(conn, STATUS_BAD_REQUEST, stat, NULL, 0);
+        }
+        memcpy(&percentile, payload, sizeof(percentile));
+        if (!(percentile >= 0.0 && percentile <= 100.0)) {
+            return append_reply(conn, STATUS_BAD_REQUEST, stat, NULL, 0);
+        }
+    } else if (size != 0 || stat < STAT_MEAN || stat > STAT_SUMMARY) {
+        return append_reply(conn, STATUS_BAD_REQUEST, stat, NULL, 0);
+    }
+
+    pthread_mutex_lock(&entry->lock);
+    StatisticsCalculator* calc = entry->calc;
+    int status = 0;
+    if (calc->count == 0) {
+        status = append_reply(conn, STATUS_EMPTY, stat, NULL, 0);
+    } else if (stat == STAT_MEAN) {
+        status = reply_double(conn, stat, calculate_mean(calc));
+    } else if (stat == STAT_MEDIAN) {
+        status = reply_double(conn, stat, calculate_median_double(calc));
+    } else if (stat == STAT_PERCENTILE) {
+        status = reply_double(conn, stat, calculate_percentile_double(calc, percentile));
+    } else {
+        StatsSummary summary;
+        fill_summary(calc, &summary);
+        status = append_reply(conn, STATUS_OK, stat, &summary, sizeof(summary));
+    }
+    pthread_mutex_unlock(&entry->lock);
+    return status;
+}
+
+// Execute one request frame (without its length prefix) and queue the reply
+static int handle_request(StatsServer* server, Connection* conn, const unsigned char* frame, size_t length) {
+    int op = frame[0];
+    int stat = frame[1];
+    uint16_t name_len;
+    memcpy(&name_len, frame + 2, sizeof(name_len));
+    size_t name_space = ((size_t)name_len + 3) & ~(size_t)3;
+    if (name_len == 0 || name_len > SERVER_MAX_NAME || 4 + name_space > length) {
+        return append_reply(conn, STATUS_BAD_REQUEST, stat, NULL, 0);
+    }
+    const char* name = (const char*)frame + 4;
+    const unsigned char* payload = frame + 4 + name_space;
+    size_t size = length - 4 - name_space;
+
+    if (op == OP_PUSH) {
+        NamedCalculator* entry = find_calculator(server, name, name_len, 1);
+        if (entry == NULL) {
+            return -1;
+        }
+        pthread_mutex_lock(&entry->lock);
+        int status = STATUS_OK;
+        size_t count = size / sizeof(int);
+        if (count > (size_t)(INT_MAX - entry->calc->count)) {
+            status = STATUS_OVERFLOW;
+        } else {
+            // Frames are 4-byte aligned in the buffer, so the values can be used in place
+            add_values(entry->calc, (const int*)payload, (int)count);
+        }
+        uint64_t total = (uint64_t)entry->calc->count;
+        pthread_mutex_unlock(&entry->lock);
+        return append_reply(conn, status, stat, &total, sizeof(total));
+    }
+    if (op != OP_QUERY && op != OP_CLEAR) {
+        return append_reply(conn, STATUS_BAD_REQUEST, stat, NULL, 0);
+    }
+    NamedCalculator* entry = find_calculator(server, name, name_len, 0);
+    if (entry == NULL) {
+        return append_reply(conn, STATUS_NOT_FOUND, stat, NULL, 0);
+    }
+    if (op == OP_QUERY) {
+        return handle_query(conn, entry, stat, payload, size);
+    }
+    pthread_mutex_lock(&entry->lock);
+    clear_data(entry->calc);
+    pthread_mutex_unlock(&entry->lock);
+    return append_reply(conn, STATUS_OK, stat, NULL, 0);
+}
+
+// Run every complete frame in the input buffer; -1 on a malformed stream
+static int process_input(StatsServer* server, Connection* conn) {
+    size_t pos = 0;
+    while (conn->in_len - pos >= sizeof(uint32_t)) {
+        uint32_t length;
+        memcpy(&length, conn->in + pos, sizeof(length));
+        if (length < 4 || length > SERVER_MAX_FRAME || length % 4 != 0) {
+            return -1;
+        }
+        if (conn->in_len - pos - sizeof(length) < length) {
+            break;
+        }
+        if (handle_request(server, conn, conn->in + pos + sizeof(length), length) != 0) {
+            return -1;
+        }
+        pos += sizeof(length) + length;
+    }
+    memmove(conn->in, conn->in + pos, conn->in_len - pos);
+    conn->in_len -= pos;
+    return 0;
+}
+
+static int flush_output(Connection* conn) {
+    while (conn->out_pos < conn->out_len) {
+        ssize_t sent = send(conn->fd, conn->out + conn->out_pos, conn->out_len - conn->out_pos, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        conn->out_pos += (size_t)sent;
+    }
+    conn->out_pos = conn->out_len = 0;
+    return 0;
+}
+
+// Read and answer everything available; returns 1 to keep the connection, 0 to close it
+static int service_connection(StatsServer* server, Connection* conn) {
+    if (flush_output(conn) != 0) {
+        return 0;
+    }
+    while (conn->out_len - conn->out_pos < SERVER_MAX_PENDING_OUTPUT) {
+        if (ensure_space(&conn->in, &conn->in_cap, conn->in_len + SERVER_READ_CHUNK) != 0) {
+            return 0;
+        }
+        ssize_t received = recv(conn->fd, conn->in + conn->in_len, conn->in_cap - conn->in_len, 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (received == 0) {
+            // Peer closed: answer what it sent before going away
+            if (process_input(server, conn) == 0) {
+                flush_output(conn);
+            }
+            return 0;
+        }
+        conn->in_len += (size_t)received;
+        if (process_input(server, conn) != 0 || flush_output(conn) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void close_connection(StatsServer* server, Connection* conn) {
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    free(conn->in);
+    free(conn->out);
+    free(conn);
+}
+
+static int arm(StatsServer* server, Connection* conn, int operation) {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT |
+                   (conn->out_pos < conn->out_len ? EPOLLOUT : 0);
+    event.data.ptr = conn;
+    return epoll_ctl(server->epoll_fd, operation, conn->fd, &event);
+}
+
+static void accept_connections(StatsServer* server) {
+    for (;;) {
+        int fd = accept4(server->listener.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        Connection* conn = (Connection*)calloc(1, sizeof(Connection));
+        if (conn == NULL) {
+            printf("Memory allocation failed\n");
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        if (arm(server, conn, EPOLL_CTL_ADD) != 0) {
+            close(fd);
+            free(conn);
+        }
+    }
+    arm(server, &server->listener, EPOLL_CTL_MOD);
+}
+
+static void* server_worker(void* arg) {
+    StatsServer* server = (StatsServer*)arg;
+    struct epoll_event events[SERVER_EVENTS];
+    while (!server_stopping) {
+        int ready = epoll_wait(server->epoll_fd, events, SERVER_EVENTS, 200);
+        for (int i = 0; i < ready; i++) {
+            Connection* conn = (Connection*)events[i].data.ptr;
+            if (conn->listening) {
+                accept_connections(server);
+            } else if (!service_connection(server, conn) || arm(server, conn, EPOLL_CTL_MOD) != 0) {
+                close_connection(server, conn);
+            }
+        }
+    }
+    return NULL;
+}
+
+// Render every calculator for a scrape. Each one is locked while it is read;
+// workers never hold two calculator locks, so taking them in bucket order is safe.
+static size_t render_server_metrics(void* context, char* buffer, size_t size) {
+    StatsServer* server = (StatsServer*)context;
+    pthread_mutex_lock(&server->registry_lock);
+    int count = 0;
+    for (int i = 0; i < SERVER_BUCKETS; i++) {
+        for (NamedCalculator* entry = server->buckets[i]; entry != NULL; entry = entry->next) {
+            count++;
+        }
+    }
+    NamedCalculator** entries = (NamedCalculator**)malloc((size_t)(count > 0 ? count : 1) * sizeof(NamedCalculator*));
+    const char** names = (const char**)malloc((size_t)(count > 0 ? count : 1) * sizeof(char*));
+    StatisticsCalculator** calcs =
+        (StatisticsCalculator**)malloc((size_t)(count > 0 ? count : 1) * sizeof(StatisticsCalculator*));
+    if (entries == NULL || names == NULL || calcs == NULL) {
+        printf("Memory allocation failed\n");
+        count = 0;
+    }
+    int filled = 0;
+    for (int i = 0; i < SERVER_BUCKETS && filled < count; i++) {
+        for (NamedCalculator* entry = server->buckets[i]; entry != NULL; entry = entry->next) {
+            entries[filled] = entry;
+            names[filled] = entry->name;
+            calcs[filled++] = entry->calc;
+        }
+    }
+    pthread_mutex_unlock(&server->registry_lock);
+
+    for (int i = 0; i < count; i++) {
+        pthread_mutex_lock(&entries[i]->lock);
+    }
+    size_t length = write_openmetrics("statistics_samples", names, calcs, count, NULL, buffer, size);
+    for (int i = 0; i < count; i++) {
+        pthread_mutex_unlock(&entries[i]->lock);
+    }
+    free(entries);
+    free(names);
+    free(calcs);
+    return length;
+}
+
+static void stop_server(int signal_number) {
+    (void)signal_number;
+    server_stopping = 1;
+}
+
+static int bind_unix_socket(const char* path, struct sockaddr_un* address) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        printf("Error: Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(address->sun_path, path);
+    return 0;
+}
+
+// Serve calculators on `path` with `workers` threads until SIGINT or SIGTERM,
+// and on 127.0.0.1:metrics_port for Prometheus unless it is 0
+int run_server(const char* path, int workers, int metrics_port) {
+    struct sockaddr_un address;
+    if (bind_unix_socket(path, &address) != 0) {
+        return -1;
+    }
+    StatsServer* server = (StatsServer*)calloc(1, sizeof(StatsServer));
+    pthread_t* threads = (pthread_t*)malloc((size_t)workers * sizeof(pthread_t));
+    if (server == NULL || threads == NULL) {
+        printf("Memory allocation failed\n");
+        free(server);
+        free(threads);
+        return -1;
+    }
+    pthread_mutex_init(&server->registry_lock, NULL);
+    unlink(path);
+    server->listener.listening = 1;
+    server->listener.fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (server->listener.fd < 0 || server->epoll_fd < 0 ||
+        bind(server->listener.fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(server->listener.fd, SOMAXCONN) != 0 ||
+        arm(server, &server->listener, EPOLL_CTL_ADD) != 0) {
+        printf("Error: Cannot listen on %s\n", path);
+        if (server->listener.fd >= 0) close(server->listener.fd);
+        if (server->epoll_fd >= 0) close(server->epoll_fd);
+        free(server);
+        free(threads);
+        return -1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_server;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    MetricsListener* metrics = NULL;
+    if (metrics_port > 0) {
+        metrics = start_metrics_listener(metrics_port, render_server_metrics, server);
+    }
+    printf("Serving statistics on %s with %d workers\n", path, workers);
+    if (metrics != NULL) {
+        printf("Serving metrics on http://127.0.0.1:%d/metrics\n", metrics_port);
+    }
+    fflush(stdout);
+
+    int started = 0;
+    while (started < workers && pthread_create(&threads[started], NULL, server_worker, server) == 0) {
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    stop_metrics_listener(metrics);
+
+    close(server->listener.fd);
+    close(server->epoll_fd);
+    unlink(path);
+    for (int i = 0; i < SERVER_BUCKETS; i++) {
+        while (server->buckets[i] != NULL) {
+            NamedCalculator* entry = server->buckets[i];
+            server->buckets[i] = entry->next;
+            pthread_mutex_destroy(&entry->lock);
+            free_calculator(entry->calc);
+            free(entry);
+        }
+    }
+    pthread_mutex_destroy(&server->registry_lock);
+    free(server);
+    free(threads);
+    return started == workers ? 0 : -1;
+}
+
+// Client side: connect to a server socket, or -1
+int stats_client_connect(const char* path) {
+    struct sockaddr_un address;
+    if (bind_unix_socket(path, &address) != 0) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    if (fd < 0) {
+        printf("Error: Cannot connect to %s\n", path);
+    }
+    return fd;
+}
+
+static int recv_all(int fd, void* data, size_t size) {
+    unsigned char* p = (unsigned char*)data;
+    while (size > 0) {
+        ssize_t received = recv(fd, p, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return -1;
+        p += received;
+        size -= (size_t)received;
+    }
+    return 0;
+}
+
+// Send one request and wait for its reply. Copies at most `reply_size` bytes
+// of the reply payload and returns the reply status, or -1 on a broken connection.
+int stats_client_request(int fd, int op, int stat, const char* name, const void* payload, size_t size,
+                         void* reply, size_t reply_size) {
+    static const unsigned char padding[4] = {0};
+    size_t name_len = strlen(name);
+    size_t name_space = (name_len + 3) & ~(size_t)3;
+    if (name_len == 0 || name_len > SERVER_MAX_NAME || size % 4 != 0 ||
+        4 + name_space + size > SERVER_MAX_FRAME) {
+        return STATUS_BAD_REQUEST;
+    }
+    uint32_t header[2];
+    header[0] = (uint32_t)(4 + name_space + size);
+    unsigned char* fields = (unsigned char*)&header[1];
+    fields[0] = (unsigned char)op;
+    fields[1] = (unsigned char)stat;
+    uint16_t encoded_len = (uint16_t)name_len;
+    memcpy(fields + 2, &encoded_len, sizeof(encoded_len));
+    struct iovec iov[4] = {
+        {header, sizeof(header)},
+        {(void*)name, name_len},
+        {(void*)padding, name_space - name_len},
+        {(void*)payload, size}
+    };
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = iov;
+    message.msg_iovlen = 4;
+    while (message.msg_iovlen > 0) {
+        ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (message.msg_iovlen > 0 && (size_t)sent >= message.msg_iov->iov_len) {
+            sent -= (ssize_t)message.msg_iov->iov_len;
+            message.msg_iov++;
+            message.msg_iovlen--;
+        }
+        if (message.msg_iovlen > 0) {
+            message.msg_iov->iov_base = (char*)message.msg_iov->iov_base + sent;
+            message.msg_iov->iov_len -= (size_t)sent;
+        }
+    }
+
+    if (recv_all(fd, header, sizeof(header)) != 0 || header[0] < 4 || header[0] > SERVER_MAX_FRAME) {
+        return -1;
+    }
+    size_t remaining = header[0] - 4;
+    size_t copied = remaining < reply_size ? remaining : reply_size;
+    if (copied > 0 && recv_all(fd, reply, copied) != 0) {
+        return -1;
+    }
+    for (remaining -= copied; remaining > 0;) {
+        unsigned char discard[256];
+        size_t chunk = remaining < sizeof(discard) ? remaining : sizeof(discard);
+        if (recv_all(fd, discard, chunk) != 0) {
+            return -1;
+        }
+        remaining -= chunk;
+    }
+    return fields[0];
+}
+
+typedef struct {
+    const char* path;
+    int id;
+    int batch;
+    double seconds;
+    uint64_t pushes;
+    uint64_t queries;
+    double query_seconds;
+    int failed;
+} LoadClient;
+
+static double monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// One load generator connection: push batches to one of 8 shared
+// calculators, querying the mean after every 16th push
+static void* load_client(void* arg) {
+    LoadClient* client = (LoadClient*)arg;
+    int fd = stats_client_connect(client->path);
+    int* values = (int*)malloc((size_t)client->batch * sizeof(int));
+    if (fd < 0 || values == NULL) {
+        client->failed = 1;
+        if (fd >= 0) close(fd);
+        free(values);
+        return NULL;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "load-%d", client->id % 8);
+    unsigned int seed = (unsigned int)client->id * 2654435761u;
+    for (int i = 0; i < client->batch; i++) {
+        values[i] = (int)(rand_r(&seed) % 100000);
+    }
+    double deadline = monotonic_seconds() + client->seconds;
+    while (monotonic_seconds() < deadline) {
+        uint64_t total;
+        if (stats_client_request(fd, OP_PUSH, 0, name, values, (size_t)client->batch * sizeof(int),
+                                 &total, sizeof(total)) != STATUS_OK) {
+            client->failed = 1;
+            break;
+        }
+        if (++client->pushes % 16 == 0) {
+            double mean;
+            double start = monotonic_seconds();
+            if (stats_client_request(fd, OP_QUERY, STAT_MEAN, name, NULL, 0, &mean, sizeof(mean)) != STATUS_OK) {
+                client->failed = 1;
+                break;
+            }
+            client->query_seconds += monotonic_seconds() - start;
+            client->queries++;
+        }
+    }
+    close(fd);
+    free(values);
+    return NULL;
+}
+
+// Drive a running server with `clients` connections for `seconds`
+int run_load_generator(const char* path, int clients, double seconds, int batch) {
+    LoadClient* load = (LoadClient*)calloc((size_t)clients, sizeof(LoadClient));
+    pthread_t* threads = (pthread_t*)malloc((size_t)clients * sizeof(pthread_t));
+    if (load == NULL || threads == NULL) {
+        printf("Memory allocation failed\n");
+        free(load);
+        free(threads);
+        return -1;
+    }
+    double start = monotonic_seconds();
+    int started = 0;
+    for (; started < clients; started++) {
+        load[started].path = path;
+        load[started].id = started;
+        load[started].batch = batch;
+        load[started].seconds = seconds;
+        if (pthread_create(&threads[started], NULL, load_client, &load[started]) != 0) {
+            break;
+        }
+    }
+    uint64_t pushes = 0, queries = 0;
+    double query_seconds = 0.0;
+    int failed = started < clients;
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        pushes += load[i].pushes;
+        queries += load[i].queries;
+        query_seconds += load[i].query_seconds;
+        failed |= load[i].failed;
+    }
+    double elapsed = monotonic_seconds() - start;
+    printf("Clients: %d, batch: %d, elapsed: %.2f s\n", started, batch, elapsed);
+    printf("Pushes: %.0f/s (%.2f M values/s)\n", pushes / elapsed, pushes * (double)batch / elapsed / 1e6);
+    printf("Queries: %.0f/s, mean latency %.1f us\n", queries / elapsed,
+           queries > 0 ? query_seconds / queries * 1e6 : 0.0);
+    free(load);
+    free(threads);
+    return failed ? -1 : 0;
+}
+
+#ifndef SERVER_NO_MAIN
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "--serve") == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        int workers = argc > 3 ? atoi(argv[3]) : (cpus > 0 ? (int)cpus : 4);
+        int metrics_port = argc > 4 ? atoi(argv[4]) : 0;
+        tune_thresholds(NULL, 0);
+        return run_server(argv[2], workers > 0 ? workers : 1, metrics_port) == 0 ? 0 : 1;
+    }
+    if (argc >= 3 && strcmp(argv[1], "--loadgen") == 0) {
+        int clients = argc > 3 ? atoi(argv[3]) : 8;
+        double seconds = argc > 4 ? atof(argv[4]) : 5.0;
+        int batch = argc > 5 ? atoi(argv[5]) : 1024;
+        if (clients <= 0 || seconds <= 0 || batch <= 0 || (size_t)batch * sizeof(int) > SERVER_MAX_FRAME / 2) {
+            printf("Error: Invalid load generator parameters\n");
+            return 1;
+        }
+        return run_load_generator(argv[2], clients, seconds, batch) == 0 ? 0 : 1;
+    }
+    printf("Usage: %s --serve <socket> [workers] [metrics_port]\n", argv[0]);
+    printf("       %s --loadgen <socket> [clients] [seconds] [batch]\n", argv[0]);
+    return 1;
+}
+#endif /* SERVER_NO_MAIN */
+
+#endif /* MULTIPARADIGM_SERVER_INCLUDED */